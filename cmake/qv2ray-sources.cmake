@@ -46,14 +46,21 @@ qv2ray_add_component(ConnectionModelHelper)
 qv2ray_add_component(FlowLayout)
 qv2ray_add_component(GeositeReader)
 qv2ray_add_component(GuiPluginHost)
+qv2ray_add_component(IPListProcessor)
 qv2ray_add_component(LogHighlighter)
+qv2ray_add_component(LogStore)
 qv2ray_add_component(MessageBus)
 qv2ray_add_component(QJsonModel)
 qv2ray_add_component(QRCodeHelper)
 qv2ray_add_component(QueryParser)
+qv2ray_add_component(RouteOptimizer)
 qv2ray_add_component(RouteSchemeIO)
+qv2ray_add_component(RouteSimulator)
 qv2ray_add_component(SpeedWidget)
 qv2ray_add_component(StyleManager)
+qv2ray_add_component(SubscriptionDiff)
+qv2ray_add_component(SubscriptionScheduler)
+qv2ray_add_component(SubscriptionUpdater)
 qv2ray_add_component(UpdateChecker)
 
 qv2ray_add_window(w_AboutWindow)
@@ -11,6 +11,35 @@
 
 const auto NumericString = [](auto i) { return u"%1"_qs.arg(i, 30, 10, QChar('0')); };
 
+// The identifiers of filter programs, in the order of their slots.
+enum FilterVariable
+{
+    Variable_Group,
+    Variable_Name,
+    Variable_Tags,
+    Variable_Latency,
+    Variable_Outbounds,
+    Variable_Inbounds,
+    Variable_Connected,
+    Variable_Protocol,
+    Variable_Address,
+    Variable_Port,
+};
+
+using Qv2ray::components::QueryParser::Compiler::VariableType;
+const static QList<Qv2ray::components::QueryParser::Compiler::Variable> FilterVariables{
+    { u"group"_qs, VariableType::String },      //
+    { u"name"_qs, VariableType::String },       //
+    { u"tags"_qs, VariableType::StringList },   //
+    { u"latency"_qs, VariableType::Number },    //
+    { u"outbounds"_qs, VariableType::Number },  //
+    { u"inbounds"_qs, VariableType::Number },   //
+    { u"connected"_qs, VariableType::Boolean }, //
+    { u"protocol"_qs, VariableType::String },   //
+    { u"address"_qs, VariableType::String },    //
+    { u"port"_qs, VariableType::Number },
+};
+
 ConnectionListHelper::ConnectionListHelper(QTreeView *parentView, QObject *parent) : QObject(parent)
 {
     this->parentView = parentView;
@@ -96,32 +125,39 @@ void ConnectionListHelper::Filter(const QString &_key)
 
 void ConnectionListHelper::Filter(const components::QueryParser::SemanticAnalyzer::Program &program)
 {
+    const components::QueryParser::Compiler::CompiledProgram compiled(program, FilterVariables, Qt::CaseInsensitive);
+    components::QueryParser::Compiler::VariableTable table(FilterVariables.size());
+    const auto currentConnection = QvKernelManager->CurrentConnection();
+
     for (const auto &groupId : QvProfileManager->GetGroups())
     {
         const auto groupIndex = model->indexFromItem(groups[groupId]);
+        const auto groupName = GetDisplayName(groupId);
         bool isTotallyHide = true;
         for (const auto &connectionId : QvProfileManager->GetConnections(groupId))
         {
-            const auto conn = QvProfileManager->GetConnection(connectionId);
-            const auto connObject = QvProfileManager->GetConnectionObject(connectionId);
-            QVariantMap variables{
-                { u"group"_qs, GetDisplayName(groupId) },
-                { u"name"_qs, GetDisplayName(connectionId) },
-                { u"tags"_qs, QVariantList(connObject.tags.begin(), connObject.tags.end()) },
-                { u"latency"_qs, connObject.latency },
-                { u"outbounds"_qs, conn.outbounds.count() },
-                { u"inbounds"_qs, conn.inbounds.count() },
-                { u"connected"_qs, QvKernelManager->CurrentConnection() == ProfileId{ connectionId, groupId } },
-            };
+            // Bound rather than copied, the table only references the name and the tags.
+            const auto &conn = QvProfileManager->GetConnection(connectionId);
+            const auto &connObject = QvProfileManager->GetConnectionObject(connectionId);
+
+            table.Clear();
+            table.SetString(Variable_Group, groupName);
+            table.SetString(Variable_Name, connObject.name);
+            table.SetStringList(Variable_Tags, connObject.tags);
+            table.SetNumber(Variable_Latency, connObject.latency);
+            table.SetNumber(Variable_Outbounds, conn.outbounds.count());
+            table.SetNumber(Variable_Inbounds, conn.inbounds.count());
+            table.SetBoolean(Variable_Connected, currentConnection == ProfileId{ connectionId, groupId });
 
             if (!conn.outbounds.isEmpty())
             {
-                variables.insert(u"protocol"_qs, conn.outbounds.first().outboundSettings.protocol);
-                variables.insert(u"address"_qs, conn.outbounds.first().outboundSettings.address);
-                variables.insert(u"port"_qs, conn.outbounds.first().outboundSettings.port.from);
+                const auto &outboundSettings = conn.outbounds.first().outboundSettings;
+                table.SetString(Variable_Protocol, outboundSettings.protocol);
+                table.SetString(Variable_Address, outboundSettings.address);
+                table.SetNumber(Variable_Port, outboundSettings.port.from);
             }
 
-            bool hasMatch = Qv2ray::components::QueryParser::EvaluateProgram(program, variables, Qt::CaseInsensitive);
+            bool hasMatch = compiled.Evaluate(table);
 
             const auto connectionIndex = model->indexFromItem(pairs[{ connectionId, groupId }]);
             parentView->setRowHidden(connectionIndex.row(), connectionIndex.parent(), !hasMatch);
@@ -0,0 +1,98 @@
+#include "IPListProcessor.hpp"
+
+#include <QHostAddress>
+#include <QSet>
+#include <algorithm>
+#include <optional>
+#include <tuple>
+
+namespace Qv2ray::components::IPListProcessor
+{
+    struct ParsedPrefix
+    {
+        bool isIPv6;
+        AddressBytes bytes;
+        int prefix;
+    };
+
+    static std::optional<ParsedPrefix> ParsePrefix(const QString &str)
+    {
+        QHostAddress addr;
+        int prefix;
+        if (str.contains(u'/'))
+        {
+            std::tie(addr, prefix) = QHostAddress::parseSubnet(str);
+        }
+        else
+        {
+            addr.setAddress(str);
+            prefix = addr.protocol() == QAbstractSocket::IPv4Protocol ? 32 : 128;
+        }
+
+        AddressBytes bytes{};
+        if (addr.protocol() == QAbstractSocket::IPv4Protocol)
+        {
+            const auto ip = addr.toIPv4Address();
+            bytes = { quint8(ip >> 24), quint8(ip >> 16), quint8(ip >> 8), quint8(ip) };
+            return ParsedPrefix{ false, bytes, prefix };
+        }
+        if (addr.protocol() == QAbstractSocket::IPv6Protocol)
+        {
+            const auto ip = addr.toIPv6Address();
+            std::copy(std::begin(ip.c), std::end(ip.c), bytes.begin());
+            return ParsedPrefix{ true, bytes, prefix };
+        }
+        return std::nullopt;
+    }
+
+    bool PrefixSet::Insert(const QString &entry)
+    {
+        const auto parsed = ParsePrefix(entry);
+        if (!parsed)
+            return false;
+        (parsed->isIPv6 ? v6 : v4).Insert(parsed->bytes, parsed->prefix);
+        return true;
+    }
+
+    bool PrefixSet::Covers(const QString &entry) const
+    {
+        const auto parsed = ParsePrefix(entry);
+        return parsed && (parsed->isIPv6 ? v6 : v4).Covers(parsed->bytes, parsed->prefix);
+    }
+
+    void PrefixSet::Collect(QStringList &out)
+    {
+        v4.Collect(out);
+        v6.Collect(out);
+    }
+
+    IPListResult AggregateIPList(const QStringList &list)
+    {
+        IPListResult result;
+        QSet<QString> references;
+        PrefixSet prefixes;
+
+        for (const auto &item : list)
+        {
+            const auto str = item.trimmed();
+            if (str.isEmpty())
+                continue;
+
+            if (str.startsWith(u"geoip:"_qs) || str.startsWith(u"ext:"_qs))
+            {
+                if (!references.contains(str))
+                {
+                    references << str;
+                    result.entries << str;
+                }
+                continue;
+            }
+
+            if (!prefixes.Insert(str))
+                result.invalid << str;
+        }
+
+        prefixes.Collect(result.entries);
+        return result;
+    }
+} // namespace Qv2ray::components::IPListProcessor
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QList>
+#include <QStringList>
+#include <array>
+
+namespace Qv2ray::components::IPListProcessor
+{
+    using AddressBytes = std::array<quint8, 16>;
+
+    // A binary trie over the address bits, a full node covers every address below it.
+    class PrefixTrie
+    {
+      public:
+        explicit PrefixTrie(int width) : width(width)
+        {
+            nodes.push_back({});
+        }
+
+        void Insert(const AddressBytes &addr, int prefix)
+        {
+            qsizetype node = 0;
+            for (auto depth = 0; depth < prefix; depth++)
+            {
+                if (nodes[node].full)
+                    return;
+
+                const auto bit = (addr[depth / 8] >> (7 - depth % 8)) & 1;
+                if (nodes[node].child[bit] == 0)
+                {
+                    nodes[node].child[bit] = nodes.size();
+                    nodes.push_back({});
+                }
+                node = nodes[node].child[bit];
+            }
+
+            // Anything more specific below is covered now.
+            nodes[node].full = true;
+            nodes[node].child[0] = nodes[node].child[1] = 0;
+        }
+
+        // Whether the prefix lies within one which has been inserted, in time linear in the prefix length.
+        bool Covers(const AddressBytes &addr, int prefix) const
+        {
+            qsizetype node = 0;
+            for (auto depth = 0; depth < prefix; depth++)
+            {
+                if (nodes[node].full)
+                    return true;
+
+                const auto bit = (addr[depth / 8] >> (7 - depth % 8)) & 1;
+                if (nodes[node].child[bit] == 0)
+                    return false;
+                node = nodes[node].child[bit];
+            }
+            return nodes[node].full;
+        }
+
+        // Merges sibling prefixes bottom-up and emits the remaining full nodes in address order.
+        void Collect(QStringList &out)
+        {
+            Merge(0);
+            AddressBytes addr{};
+            Collect(0, 0, addr, out);
+        }
+
+      private:
+        bool Merge(qsizetype index)
+        {
+            auto &node = nodes[index];
+            if (node.full)
+                return true;
+
+            const auto left = node.child[0] != 0 && Merge(node.child[0]);
+            const auto right = node.child[1] != 0 && Merge(node.child[1]);
+            if (left && right)
+            {
+                node.full = true;
+                node.child[0] = node.child[1] = 0;
+            }
+            return node.full;
+        }
+
+        void Collect(qsizetype index, int depth, AddressBytes &addr, QStringList &out) const
+        {
+            const auto &node = nodes[index];
+            if (node.full)
+            {
+                QHostAddress host;
+                if (width == 32)
+                    host.setAddress(quint32(addr[0]) << 24 | quint32(addr[1]) << 16 | quint32(addr[2]) << 8 | quint32(addr[3]));
+                else
+                    host.setAddress(addr.data());
+                out << host.toString() + u'/' + QString::number(depth);
+                return;
+            }
+
+            for (auto bit = 0; bit < 2; bit++)
+            {
+                if (node.child[bit] == 0)
+                    continue;
+                const quint8 mask = 1 << (7 - depth % 8);
+                if (bit)
+                    addr[depth / 8] |= mask;
+                Collect(node.child[bit], depth + 1, addr, out);
+                addr[depth / 8] &= ~mask;
+            }
+        }
+
+      private:
+        struct Node
+        {
+            // The root is never a child, so 0 means no child.
+            qsizetype child[2] = { 0, 0 };
+            bool full = false;
+        };
+
+        const int width;
+        QList<Node> nodes;
+    };
+
+    // IPv4 and IPv6 prefixes, given as addresses or CIDRs.
+    class PrefixSet
+    {
+      public:
+        // Returns false if the entry is neither an address nor a CIDR.
+        bool Insert(const QString &entry);
+        // Whether the address or CIDR lies within one of the inserted prefixes.
+        bool Covers(const QString &entry) const;
+        // The minimal sorted set of prefixes covering the inserted ones, IPv4 first.
+        void Collect(QStringList &out);
+
+      private:
+        PrefixTrie v4{ 32 };
+        PrefixTrie v6{ 128 };
+    };
+
+    struct IPListResult
+    {
+        // geoip: and ext: references in their original order, followed by the aggregated IPv4 and IPv6 prefixes.
+        QStringList entries;
+        // Entries which are neither a reference, an address nor a CIDR.
+        QStringList invalid;
+    };
+
+    // Merges addresses and CIDRs into the minimal sorted set of prefixes covering exactly the same addresses.
+    IPListResult AggregateIPList(const QStringList &list);
+} // namespace Qv2ray::components::IPListProcessor
+
+using namespace Qv2ray::components::IPListProcessor;
@@ -0,0 +1,382 @@
+#include "LogStore.hpp"
+
+#include <QDateTime>
+#include <algorithm>
+#include <limits>
+#include <optional>
+
+namespace Qv2ray::components::LogStore
+{
+    static bool ReadDigits(QStringView str, qsizetype pos, qsizetype count, int &out)
+    {
+        out = 0;
+        for (auto i = pos; i < pos + count; i++)
+        {
+            if (!str[i].isDigit())
+                return false;
+            out = out * 10 + str[i].digitValue();
+        }
+        return true;
+    }
+
+    // "2021/10/18 12:34:56" with an optional fraction part, consumed from the front of the line.
+    static qint64 ReadTimestamp(QStringView &line, LogDayCache &dayCache)
+    {
+        int year, month, day, hour, minute, second;
+        if (line.size() < 19)
+            return 0;
+
+        if (!(ReadDigits(line, 0, 4, year) && line[4] == u'/' && ReadDigits(line, 5, 2, month) && line[7] == u'/' && ReadDigits(line, 8, 2, day) && line[10] == u' ' &&
+              ReadDigits(line, 11, 2, hour) && line[13] == u':' && ReadDigits(line, 14, 2, minute) && line[16] == u':' && ReadDigits(line, 17, 2, second)))
+            return 0;
+
+        qsizetype consumed = 19;
+        if (consumed < line.size() && line[consumed] == u'.')
+            while (++consumed < line.size() && line[consumed].isDigit())
+                ;
+        line = line.mid(consumed).trimmed();
+
+        const QDate date{ year, month, day };
+        if (date != dayCache.date)
+        {
+            dayCache.date = date;
+            dayCache.dayStart = QDateTime{ date, QTime{ 0, 0 } }.toSecsSinceEpoch();
+        }
+        return dayCache.dayStart + hour * 3600 + minute * 60 + second;
+    }
+
+    static LogLevel ReadLevel(QStringView level)
+    {
+        if (level.compare(u"Debug", Qt::CaseInsensitive) == 0)
+            return LEVEL_DEBUG;
+        if (level.compare(u"Info", Qt::CaseInsensitive) == 0)
+            return LEVEL_INFO;
+        if (level.compare(u"Warning", Qt::CaseInsensitive) == 0)
+            return LEVEL_WARNING;
+        if (level.compare(u"Error", Qt::CaseInsensitive) == 0)
+            return LEVEL_ERROR;
+        return LEVEL_UNKNOWN;
+    }
+
+    static QStringView LevelToString(LogLevel level)
+    {
+        switch (level)
+        {
+            case LEVEL_DEBUG: return u"debug";
+            case LEVEL_INFO: return u"info";
+            case LEVEL_WARNING: return u"warning";
+            case LEVEL_ERROR: return u"error";
+            case LEVEL_ACCESS: return u"access";
+            case LEVEL_UNKNOWN: break;
+        }
+        return u"";
+    }
+
+    // The identifiers of filter programs, in the order of their slots.
+    enum FilterVariable
+    {
+        Variable_Time,
+        Variable_Age,
+        Variable_Level,
+        Variable_Source,
+        Variable_Destination,
+        Variable_Network,
+        Variable_Host,
+        Variable_Port,
+        Variable_Inbound,
+        Variable_Outbound,
+        Variable_Line,
+    };
+
+    using QueryParser::Compiler::VariableType;
+    const static QList<QueryParser::Compiler::Variable> FilterVariables{
+        { u"time"_qs, VariableType::Number },        //
+        { u"age"_qs, VariableType::Number },         //
+        { u"level"_qs, VariableType::String },       //
+        { u"source"_qs, VariableType::String },      //
+        { u"destination"_qs, VariableType::String }, //
+        { u"network"_qs, VariableType::String },     //
+        { u"host"_qs, VariableType::String },        //
+        { u"port"_qs, VariableType::Number },        //
+        { u"inbound"_qs, VariableType::String },     //
+        { u"outbound"_qs, VariableType::String },    //
+        { u"line"_qs, VariableType::String },
+    };
+
+    // "tcp:www.example.com:443", "udp:[::1]:53" or "1.1.1.1:53"
+    static void SplitDestination(QStringView dest, QStringView *network, QStringView *host, QStringView *port)
+    {
+        if (dest.startsWith(u"tcp:") || dest.startsWith(u"udp:"))
+        {
+            if (network)
+                *network = dest.first(3);
+            dest = dest.mid(4);
+        }
+
+        qsizetype colon = -1;
+        if (dest.startsWith(u'['))
+        {
+            const auto bracket = dest.indexOf(u']');
+            if (host)
+                *host = bracket < 0 ? dest.mid(1) : dest.mid(1, bracket - 1);
+            colon = bracket < 0 ? -1 : dest.indexOf(u':', bracket);
+        }
+        else
+        {
+            colon = dest.lastIndexOf(u':');
+            if (host)
+                *host = colon < 0 ? dest : dest.first(colon);
+        }
+
+        if (port && colon >= 0)
+            *port = dest.mid(colon + 1);
+    }
+
+    LogRecord ParseLogLine(const QString &line, LogDayCache &dayCache)
+    {
+        LogRecord record;
+        record.line = line;
+
+        QStringView rest{ line };
+        rest = rest.trimmed();
+        record.timestamp = ReadTimestamp(rest, dayCache);
+
+        if (rest.startsWith(u'['))
+        {
+            // Error log: "[Info] [1234567] app/dispatcher: taking detour [proxy] for [tcp:www.example.com:443]"
+            const auto levelEnd = rest.indexOf(u']');
+            if (levelEnd > 0)
+                record.level = ReadLevel(rest.mid(1, levelEnd - 1));
+
+            constexpr QStringView detourMark = u"taking detour [";
+            if (const auto detour = rest.indexOf(detourMark); detour >= 0)
+            {
+                const auto tagBegin = detour + detourMark.size();
+                const auto tagEnd = rest.indexOf(u']', tagBegin);
+                const auto destBegin = tagEnd < 0 ? 0 : rest.indexOf(u'[', tagEnd) + 1;
+                const auto destEnd = destBegin <= 0 ? -1 : rest.indexOf(u']', destBegin);
+                if (destEnd > 0)
+                {
+                    record.outboundTag = rest.mid(tagBegin, tagEnd - tagBegin).toString();
+                    record.destination = rest.mid(destBegin, destEnd - destBegin).toString();
+                }
+            }
+        }
+        else
+        {
+            // Access log: "127.0.0.1:50000 accepted tcp:www.example.com:443 [socks-in-1 -> proxy]"
+            auto verb = rest.indexOf(u" accepted ");
+            if (verb < 0)
+                verb = rest.indexOf(u" rejected ");
+            if (verb < 0)
+                return record;
+
+            record.level = LEVEL_ACCESS;
+            auto source = rest.first(verb).trimmed();
+            if (source.startsWith(u"from "))
+                source = source.mid(5).trimmed();
+            record.source = source.toString();
+
+            const auto target = rest.mid(verb + 10).trimmed();
+            const auto destEnd = target.indexOf(u' ');
+            record.destination = (destEnd < 0 ? target : target.first(destEnd)).toString();
+
+            const auto routeBegin = target.indexOf(u'[');
+            const auto routeEnd = target.indexOf(u']', routeBegin);
+            if (routeBegin >= 0 && routeEnd > routeBegin)
+            {
+                const auto route = target.mid(routeBegin + 1, routeEnd - routeBegin - 1);
+                auto arrow = route.indexOf(u" -> ");
+                if (arrow < 0)
+                    arrow = route.indexOf(u" >> ");
+                if (arrow >= 0)
+                {
+                    record.inboundTag = route.first(arrow).trimmed().toString();
+                    record.outboundTag = route.mid(arrow + 4).trimmed().toString();
+                }
+                else
+                {
+                    record.inboundTag = route.trimmed().toString();
+                }
+            }
+        }
+
+        if (!record.destination.isEmpty())
+        {
+            QStringView host;
+            SplitDestination(record.destination, nullptr, &host, nullptr);
+            record.host = host.toString();
+        }
+
+        return record;
+    }
+
+    KernelLogStore::KernelLogStore(qsizetype capacity) : capacity(capacity)
+    {
+    }
+
+    qsizetype KernelLogStore::Append(const QString &chunk)
+    {
+        qsizetype appended = 0;
+        for (const auto &line : QStringView{ chunk }.split(u'\n', Qt::SkipEmptyParts))
+        {
+            const auto trimmed = line.trimmed();
+            if (trimmed.isEmpty())
+                continue;
+            AppendRecord(ParseLogLine(trimmed.toString(), dayCache));
+            appended++;
+        }
+
+        // Drop a quarter at once so that the indexes are not rebuilt for every new line.
+        if (Size() > capacity)
+            TrimFront(Size() - capacity + capacity / 4);
+
+        return std::max<qsizetype>(0, Size() - appended);
+    }
+
+    void KernelLogStore::Clear()
+    {
+        columns.timestamp.clear();
+        columns.level.clear();
+        columns.source.clear();
+        columns.destination.clear();
+        columns.host.clear();
+        columns.inboundTag.clear();
+        columns.outboundTag.clear();
+        columns.line.clear();
+        hostIndex.clear();
+        tagIndex.clear();
+    }
+
+    void KernelLogStore::AppendRecord(LogRecord &&record)
+    {
+        const auto row = Size();
+        if (!record.host.isEmpty())
+            hostIndex[record.host.toLower()].append(row);
+        if (!record.inboundTag.isEmpty())
+            tagIndex[record.inboundTag.toLower()].append(row);
+        if (!record.outboundTag.isEmpty() && record.outboundTag.compare(record.inboundTag, Qt::CaseInsensitive) != 0)
+            tagIndex[record.outboundTag.toLower()].append(row);
+
+        columns.timestamp.append(record.timestamp);
+        columns.level.append(record.level);
+        columns.source.append(std::move(record.source));
+        columns.destination.append(std::move(record.destination));
+        columns.host.append(std::move(record.host));
+        columns.inboundTag.append(std::move(record.inboundTag));
+        columns.outboundTag.append(std::move(record.outboundTag));
+        columns.line.append(std::move(record.line));
+    }
+
+    void KernelLogStore::TrimFront(qsizetype count)
+    {
+        count = std::min(count, Size());
+        columns.timestamp.remove(0, count);
+        columns.level.remove(0, count);
+        columns.source.remove(0, count);
+        columns.destination.remove(0, count);
+        columns.host.remove(0, count);
+        columns.inboundTag.remove(0, count);
+        columns.outboundTag.remove(0, count);
+        columns.line.remove(0, count);
+        RebuildIndexes();
+    }
+
+    void KernelLogStore::RebuildIndexes()
+    {
+        hostIndex.clear();
+        tagIndex.clear();
+        for (qsizetype row = 0; row < Size(); row++)
+        {
+            if (!columns.host[row].isEmpty())
+                hostIndex[columns.host[row].toLower()].append(row);
+            if (!columns.inboundTag[row].isEmpty())
+                tagIndex[columns.inboundTag[row].toLower()].append(row);
+            if (!columns.outboundTag[row].isEmpty() && columns.outboundTag[row].compare(columns.inboundTag[row], Qt::CaseInsensitive) != 0)
+                tagIndex[columns.outboundTag[row].toLower()].append(row);
+        }
+    }
+
+    void KernelLogStore::FillVariables(qsizetype row, qint64 now, QueryParser::Compiler::VariableTable &table) const
+    {
+        QStringView network, host, port;
+        SplitDestination(columns.destination[row], &network, &host, &port);
+        const auto timestamp = columns.timestamp[row];
+        table.SetNumber(Variable_Time, timestamp);
+        table.SetNumber(Variable_Age, timestamp == 0 ? std::numeric_limits<qint64>::max() : std::max<qint64>(0, now - timestamp));
+        table.SetString(Variable_Level, LevelToString(columns.level[row]));
+        table.SetString(Variable_Source, columns.source[row]);
+        table.SetString(Variable_Destination, columns.destination[row]);
+        table.SetString(Variable_Network, network);
+        table.SetString(Variable_Host, columns.host[row]);
+        table.SetNumber(Variable_Port, port.toInt());
+        table.SetString(Variable_Inbound, columns.inboundTag[row]);
+        table.SetString(Variable_Outbound, columns.outboundTag[row]);
+        table.SetString(Variable_Line, columns.line[row]);
+    }
+
+    LogFilter::LogFilter(const QueryParser::SemanticAnalyzer::Program &program) : compiled(program, FilterVariables, Qt::CaseInsensitive)
+    {
+        using QueryParser::SemanticAnalyzer::Operator;
+        for (const auto &statement : program)
+        {
+            if (statement.op != Operator::Equal || statement.hasArgList || statement.arg.typeId() != QMetaType::QString)
+                continue;
+
+            const auto identifier = statement.oprand.toString();
+            if (identifier == u"host"_qs)
+                lookups.append({ true, statement.arg.toString().toLower() });
+            else if (identifier == u"inbound"_qs || identifier == u"outbound"_qs)
+                lookups.append({ false, statement.arg.toString().toLower() });
+        }
+    }
+
+    QList<qsizetype> KernelLogStore::Filter(const LogFilter &filter, qsizetype from) const
+    {
+        // Plain equality tests on indexed columns narrow down the rows, the program itself is still evaluated on every candidate.
+        std::optional<QList<qsizetype>> candidates;
+        for (const auto &lookup : filter.lookups)
+        {
+            const auto rows = (lookup.isHost ? hostIndex : tagIndex).value(lookup.key);
+            if (!candidates)
+            {
+                candidates = rows;
+                continue;
+            }
+
+            QList<qsizetype> intersection;
+            std::set_intersection(candidates->cbegin(), candidates->cend(), rows.cbegin(), rows.cend(), std::back_inserter(intersection));
+            candidates = intersection;
+        }
+
+        QueryParser::Compiler::VariableTable table(FilterVariables.size());
+        const auto now = QDateTime::currentSecsSinceEpoch();
+
+        QList<qsizetype> result;
+        const auto evaluate = [&](qsizetype row)
+        {
+            if (row < from)
+                return;
+            FillVariables(row, now, table);
+            if (filter.compiled.Evaluate(table))
+                result << row;
+        };
+
+        if (candidates)
+            std::for_each(candidates->cbegin(), candidates->cend(), evaluate);
+        else
+            for (auto row = from; row < Size(); row++)
+                evaluate(row);
+
+        return result;
+    }
+
+    QList<qsizetype> KernelLogStore::Filter(const QString &keyword, qsizetype from) const
+    {
+        QList<qsizetype> result;
+        for (auto row = from; row < Size(); row++)
+            if (columns.line[row].contains(keyword, Qt::CaseInsensitive))
+                result << row;
+        return result;
+    }
+} // namespace Qv2ray::components::LogStore
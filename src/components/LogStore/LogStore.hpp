@@ -0,0 +1,113 @@
+#pragma once
+
+#include "components/QueryParser/QueryParser.hpp"
+
+#include <QDate>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+namespace Qv2ray::components::LogStore
+{
+    enum LogLevel
+    {
+        LEVEL_UNKNOWN,
+        LEVEL_DEBUG,
+        LEVEL_INFO,
+        LEVEL_WARNING,
+        LEVEL_ERROR,
+        LEVEL_ACCESS,
+    };
+
+    struct LogRecord
+    {
+        qint64 timestamp = 0;
+        LogLevel level = LEVEL_UNKNOWN;
+        QString source;
+        QString destination;
+        QString host;
+        QString inboundTag;
+        QString outboundTag;
+        QString line;
+    };
+
+    // The start of the day of the last parsed line. Local time conversion is expensive, and log lines from the same day
+    // come in bulk.
+    struct LogDayCache
+    {
+        QDate date;
+        qint64 dayStart = 0;
+    };
+
+    LogRecord ParseLogLine(const QString &line, LogDayCache &dayCache);
+
+    // A filter program compiled once against the columns of the store, then evaluated on any number of lines.
+    class LogFilter
+    {
+      public:
+        // Throws a semantic_error if the program uses an identifier which is not a column.
+        explicit LogFilter(const QueryParser::SemanticAnalyzer::Program &program);
+
+      private:
+        friend class KernelLogStore;
+        QueryParser::Compiler::CompiledProgram compiled;
+        // Plain equality tests on indexed columns, with the lowercased value, they narrow down the rows.
+        struct IndexLookup
+        {
+            bool isHost;
+            QString key;
+        };
+        QList<IndexLookup> lookups;
+    };
+
+    // Kernel log lines, parsed and stored column by column, with inverted indexes on host and tag.
+    class KernelLogStore
+    {
+      public:
+        explicit KernelLogStore(qsizetype capacity = 50000);
+
+        // Splits the chunk into lines and appends them, returns the row index of the first appended line.
+        qsizetype Append(const QString &chunk);
+        void Clear();
+
+        qsizetype Size() const
+        {
+            return columns.line.size();
+        }
+
+        const QString &Line(qsizetype row) const
+        {
+            return columns.line.at(row);
+        }
+
+        QList<qsizetype> Filter(const LogFilter &filter, qsizetype from = 0) const;
+        QList<qsizetype> Filter(const QString &keyword, qsizetype from = 0) const;
+
+      private:
+        void AppendRecord(LogRecord &&record);
+        void TrimFront(qsizetype count);
+        void RebuildIndexes();
+        void FillVariables(qsizetype row, qint64 now, QueryParser::Compiler::VariableTable &table) const;
+
+      private:
+        const qsizetype capacity;
+        LogDayCache dayCache;
+        struct
+        {
+            QList<qint64> timestamp;
+            QList<LogLevel> level;
+            QList<QString> source;
+            QList<QString> destination;
+            QList<QString> host;
+            QList<QString> inboundTag;
+            QList<QString> outboundTag;
+            QList<QString> line;
+        } columns;
+
+        // Keys are lowercased, values are sorted row indexes.
+        QHash<QString, QList<qsizetype>> hostIndex;
+        QHash<QString, QList<qsizetype>> tagIndex;
+    };
+} // namespace Qv2ray::components::LogStore
+
+using namespace Qv2ray::components::LogStore;
@@ -1,5 +1,8 @@
 #include "QueryParser.hpp"
 
+#include <algorithm>
+#include <optional>
+
 using namespace Qv2ray::components::QueryParser;
 
 const static inline QMap<Tokenizer::TokenOperator, QString> operator_maps{
@@ -395,98 +398,144 @@ SemanticAnalyzer::Program SemanticAnalyzer::SemanticAnalyze(const QList<SyntaxAn
     return result;
 }
 
-bool Qv2ray::components::QueryParser::EvaluateProgram(const SemanticAnalyzer::Program &prog, const QVariantMap &variables, Qt::CaseSensitivity caseSensitive)
+// Converts a literal to the number, or the 0 or 1 of a boolean, which a variable of the type is compared with.
+static std::optional<qint64> ToNumber(const QVariant &literal, Compiler::VariableType type)
 {
-    bool result = true;
-    for (const auto &statement : prog)
-    {
-        const auto oprand = statement.oprand.toString();
-        if (!variables[oprand].isValid())
-            throw evaluation_error("unknown identifier: " + oprand.toStdString());
+    if (literal.typeId() == QMetaType::Bool)
+        return literal.toBool() ? 1 : 0;
+
+    if (literal.typeId() == QMetaType::LongLong)
+        return type == Compiler::VariableType::Boolean ? literal.toLongLong() != 0 : literal.toLongLong();
+
+    const auto string = literal.toString();
+    if (type == Compiler::VariableType::Boolean && string.compare(u"true"_qs, Qt::CaseInsensitive) == 0)
+        return 1;
+    if (type == Compiler::VariableType::Boolean && string.compare(u"false"_qs, Qt::CaseInsensitive) == 0)
+        return 0;
+
+    bool ok = false;
+    const auto number = string.toLongLong(&ok);
+    if (!ok)
+        return std::nullopt;
+    return type == Compiler::VariableType::Boolean ? number != 0 : number;
+}
 
-        const auto opcode = statement.op;
+Compiler::CompiledProgram::CompiledProgram(const SemanticAnalyzer::Program &program, const QList<Variable> &variables, Qt::CaseSensitivity caseSensitive)
+    : caseSensitive(caseSensitive)
+{
+    using SemanticAnalyzer::Operator;
 
-        const auto hasArgList = statement.hasArgList;
+    for (const auto &variable : variables)
+        names << variable.name;
 
-        const auto _contains = [caseSensitive](const QVariantList &list, const QVariant &v) -> bool
-        {
-            const auto _Pred = [&](const QVariant &vv) -> bool
-            {
-                if (v.typeId() == QMetaType::QString)
-                    return v.toString().compare(vv.toString(), caseSensitive) == 0;
-                return vv == v;
-            };
-            return std::find_if(list.begin(), list.end(), _Pred) != list.end();
-        };
-
-        switch (opcode)
+    instructions.reserve(program.size());
+    for (const auto &statement : program)
+    {
+        const auto identifier = statement.oprand.toString();
+        const auto slot = names.indexOf(identifier);
+        if (slot < 0)
+            throw semantic_error("unknown identifier: " + identifier.toStdString());
+
+        Instruction instruction;
+        instruction.opcode = statement.op == Operator::Equal || statement.op == Operator::NotEqual ? Opcode::Equal : Opcode::Order;
+        instruction.op = statement.op;
+        instruction.slot = slot;
+        instruction.type = variables[slot].type;
+        instruction.matchAll = statement.args.argsop == Operator::And;
+        instruction.hasUnmatchable = false;
+
+        for (const auto &argument : statement.hasArgList ? statement.args.args : QVariantList{ statement.arg })
         {
-            case SemanticAnalyzer::Operator::Equal:
-            case SemanticAnalyzer::Operator::NotEqual:
+            if (instruction.opcode == Opcode::Order)
             {
-                const auto positivePredicate = opcode == SemanticAnalyzer::Operator::Equal;
+                // Orders are compared unsigned, a negative bound is as unmatchable as one which is not a number.
+                if (const auto number = ToNumber(argument, VariableType::Number); number && *number >= 0)
+                    instruction.numbers << *number;
+                else
+                    instruction.hasUnmatchable = true;
+            }
+            else if (instruction.type == VariableType::String || instruction.type == VariableType::StringList)
+                instruction.strings << argument.toString();
+            else if (const auto number = ToNumber(argument, instruction.type); number)
+                instruction.numbers << *number;
+            else
+                instruction.hasUnmatchable = true;
+        }
+        instructions << instruction;
+    }
+}
 
-                const auto variableMetaTypeId = variables[oprand].metaType().id();
-                if (variableMetaTypeId == QMetaType::QStringList || variableMetaTypeId == QMetaType::QVariantList)
-                {
-                    QVariantList list = statement.args.args;
+bool Compiler::CompiledProgram::Evaluate(const VariableTable &table) const
+{
+    for (const auto &instruction : instructions)
+    {
+        Q_ASSERT(instruction.slot < table.values.size());
+        const auto &value = table.values.at(instruction.slot);
+        if (!value.isSet)
+            throw evaluation_error("unknown identifier: " + names.at(instruction.slot).toStdString());
 
-                    if (!hasArgList)
-                        list << statement.arg;
+        // Statements are joined by "and".
+        if (!Matches(instruction, value))
+            return false;
+    }
+    return true;
+}
 
-                    const auto valList = variables[oprand].toList();
+bool Compiler::CompiledProgram::Matches(const Instruction &instruction, const VariableTable::Value &value) const
+{
+    using SemanticAnalyzer::Operator;
 
-                    // If Or, default value = true;
-                    bool r = statement.args.argsop == SemanticAnalyzer::Operator::And;
-                    for (const auto &a : list)
-                    {
-                        if (statement.args.argsop == SemanticAnalyzer::Operator::And)
-                            r &= _contains(valList, a);
-                        else
-                            r |= _contains(valList, a);
-                    }
+    if (instruction.opcode == Opcode::Order)
+    {
+        if (instruction.hasUnmatchable)
+            return false;
 
-                    if (positivePredicate)
-                        result &= r;
-                    else
-                        result &= !r;
-                }
-                else
-                {
-                    if (positivePredicate)
-                        result &= statement.arg == variables[oprand];
-                    else
-                        result &= statement.arg != variables[oprand];
-                }
-                break;
-            }
-            case SemanticAnalyzer::Operator::LessThan:
-            {
-                Q_ASSERT(!hasArgList);
-                result &= variables[oprand].toULongLong() < statement.arg.toULongLong();
-                break;
-            }
-            case SemanticAnalyzer::Operator::GreaterThan:
-            {
-                Q_ASSERT(!hasArgList);
-                result &= variables[oprand].toULongLong() > statement.arg.toULongLong();
-                break;
-            }
-            case SemanticAnalyzer::Operator::LessEqualThan:
-            {
-                Q_ASSERT(!hasArgList);
-                result &= variables[oprand].toULongLong() <= statement.arg.toULongLong();
-                break;
-            }
-            case SemanticAnalyzer::Operator::GreaterEqualThan:
-            {
-                Q_ASSERT(!hasArgList);
-                result &= variables[oprand].toULongLong() >= statement.arg.toULongLong();
-                break;
-            }
+        quint64 variable = 0;
+        switch (instruction.type)
+        {
+            case VariableType::Number:
+            case VariableType::Boolean: variable = quint64(value.number); break;
+            case VariableType::String: variable = value.string.toULongLong(); break;
+            case VariableType::StringList: break;
+        }
 
+        const auto argument = quint64(instruction.numbers.first());
+        switch (instruction.op)
+        {
+            case Operator::LessThan: return variable < argument;
+            case Operator::GreaterThan: return variable > argument;
+            case Operator::LessEqualThan: return variable <= argument;
+            case Operator::GreaterEqualThan: return variable >= argument;
             default: Q_UNREACHABLE();
         }
     }
-    return result;
+
+    const auto isNumeric = instruction.type == VariableType::Number || instruction.type == VariableType::Boolean;
+    const auto matches = [&](qsizetype i) -> bool
+    {
+        if (isNumeric)
+            return value.number == instruction.numbers[i];
+        if (instruction.type == VariableType::String)
+            return value.string.compare(instruction.strings[i], caseSensitive) == 0;
+
+        const auto &argument = instruction.strings[i];
+        const auto equals = [&](const QString &item) { return item.compare(argument, caseSensitive) == 0; };
+        if (value.set)
+            return std::any_of(value.set->cbegin(), value.set->cend(), equals);
+        return std::any_of(value.list->cbegin(), value.list->cend(), equals);
+    };
+
+    const auto count = isNumeric ? instruction.numbers.size() : instruction.strings.size();
+    auto result = instruction.matchAll && !instruction.hasUnmatchable;
+    if (instruction.matchAll)
+    {
+        for (qsizetype i = 0; result && i < count; i++)
+            result = matches(i);
+    }
+    else
+    {
+        for (qsizetype i = 0; !result && i < count; i++)
+            result = matches(i);
+    }
+    return instruction.op == Operator::Equal ? result : !result;
 }
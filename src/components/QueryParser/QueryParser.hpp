@@ -1,5 +1,8 @@
 #pragma once
 
+#include <QSet>
+#include <QStringList>
+#include <QStringView>
 #include <QVariant>
 #include <stdexcept>
 
@@ -169,6 +172,113 @@ namespace Qv2ray::components::QueryParser
         Program SemanticAnalyze(const QList<SyntaxAnalyzer::SyntaxStatement> &statements);
     } // namespace SemanticAnalyzer
 
+    namespace Compiler
+    {
+        enum class VariableType
+        {
+            Number,
+            Boolean,
+            String,
+            StringList,
+        };
+
+        struct Variable
+        {
+            QString name;
+            VariableType type;
+        };
+
+        // The values of the variables of one row, in the order of their declarations. Strings and lists are referenced
+        // rather than copied so that filling the table does not allocate, they must outlive the evaluation.
+        class VariableTable
+        {
+          public:
+            explicit VariableTable(qsizetype size) : values(size){};
+
+            void Clear()
+            {
+                for (auto &value : values)
+                    value.isSet = false;
+            }
+            void SetNumber(qsizetype slot, qint64 number)
+            {
+                values[slot] = { true, number, {}, nullptr, nullptr };
+            }
+            void SetBoolean(qsizetype slot, bool boolean)
+            {
+                values[slot] = { true, boolean, {}, nullptr, nullptr };
+            }
+            void SetString(qsizetype slot, QStringView string)
+            {
+                values[slot] = { true, 0, string, nullptr, nullptr };
+            }
+            void SetString(qsizetype slot, const QString &string)
+            {
+                SetString(slot, QStringView(string));
+            }
+            void SetStringList(qsizetype slot, const QStringList &list)
+            {
+                values[slot] = { true, 0, {}, &list, nullptr };
+            }
+            // A set is a list variable too, such as the tags of a connection.
+            void SetStringList(qsizetype slot, const QSet<QString> &set)
+            {
+                values[slot] = { true, 0, {}, nullptr, &set };
+            }
+
+          private:
+            friend class CompiledProgram;
+            struct Value
+            {
+                bool isSet = false;
+                qint64 number = 0;
+                QStringView string;
+                const QStringList *list = nullptr;
+                const QSet<QString> *set = nullptr;
+            };
+            QList<Value> values;
+        };
+
+        // A program whose identifiers are resolved to slots and whose literals are converted to the types of the variables
+        // they are compared with, so that evaluating it neither looks up, converts nor allocates anything.
+        class CompiledProgram
+        {
+          public:
+            // Throws a semantic_error if the program uses an identifier which is not declared.
+            CompiledProgram(const SemanticAnalyzer::Program &program, const QList<Variable> &variables, Qt::CaseSensitivity caseSensitive = Qt::CaseSensitive);
+            bool Evaluate(const VariableTable &table) const;
+
+          private:
+            enum class Opcode
+            {
+                Equal,
+                Order,
+            };
+
+            struct Instruction
+            {
+                Opcode opcode;
+                SemanticAnalyzer::Operator op;
+                qsizetype slot;
+                VariableType type;
+                // Whether every argument must match rather than any of them.
+                bool matchAll;
+                // Set when an argument cannot be converted to the type of the variable, it never matches.
+                bool hasUnmatchable;
+                // The arguments, in the representation of the variable type.
+                QList<qint64> numbers;
+                QStringList strings;
+            };
+
+            bool Matches(const Instruction &instruction, const VariableTable::Value &value) const;
+
+          private:
+            QList<Instruction> instructions;
+            QStringList names;
+            Qt::CaseSensitivity caseSensitive;
+        };
+    } // namespace Compiler
+
     inline SemanticAnalyzer::Program ParseProgram(const QString &source)
     {
         using namespace SemanticAnalyzer;
@@ -177,6 +287,4 @@ namespace Qv2ray::components::QueryParser
         return SemanticAnalyze(SyntaxAnalyze(Tokenize(source)));
     }
 
-    bool EvaluateProgram(const SemanticAnalyzer::Program &prog, const QVariantMap &variables, Qt::CaseSensitivity caseSensitive = Qt::CaseSensitive);
-
 } // namespace Qv2ray::components::QueryParser
@@ -0,0 +1,137 @@
+#include "RouteOptimizer.hpp"
+
+#include "components/IPListProcessor/IPListProcessor.hpp"
+
+#include <QSet>
+#include <algorithm>
+
+namespace Qv2ray::components::RouteOptimizer
+{
+    using ConditionList = QList<QString> RuleObject::*;
+    static const ConditionList ConditionLists[] = {
+        &RuleObject::targetDomains,   //
+        &RuleObject::targetIPs,       //
+        &RuleObject::sourceAddresses, //
+        &RuleObject::inboundTags,     //
+        &RuleObject::protocols,       //
+        &RuleObject::networks,        //
+    };
+    constexpr auto ConditionListsCount = sizeof(ConditionLists) / sizeof(ConditionLists[0]);
+
+    static bool IsIPList(ConditionList list)
+    {
+        return list == &RuleObject::targetIPs || list == &RuleObject::sourceAddresses;
+    }
+
+    static bool HasPort(const decltype(RuleObject::targetPort) &port)
+    {
+        return port.from != 0 && port.to != 0;
+    }
+
+    static bool SamePort(const decltype(RuleObject::targetPort) &a, const decltype(RuleObject::targetPort) &b)
+    {
+        return a.from == b.from && a.to == b.to;
+    }
+
+    // Removes duplicate entries, IP lists are aggregated into the minimal set of prefixes.
+    static void DeduplicateList(QList<QString> &list, bool isIPList)
+    {
+        if (!isIPList)
+        {
+            list.removeDuplicates();
+            return;
+        }
+
+        // Invalid entries are left for the core to report.
+        auto [entries, invalid] = AggregateIPList(list);
+        list = entries + invalid;
+    }
+
+    // The condition list of a rule which has exactly one condition, or nullptr.
+    static ConditionList SingleCondition(const RuleObject &rule)
+    {
+        if (HasPort(rule.targetPort) || HasPort(rule.sourcePort) || !rule.extraSettings.isEmpty())
+            return nullptr;
+
+        ConditionList result = nullptr;
+        for (const auto list : ConditionLists)
+        {
+            if ((rule.*list).isEmpty())
+                continue;
+            if (result)
+                return nullptr;
+            result = list;
+        }
+        return result;
+    }
+
+    // Two rules can be merged when they only differ in one condition list, the merged rule matches what either of them does.
+    static bool TryMerge(RuleObject &into, const RuleObject &rule)
+    {
+        if (into.outboundTag != rule.outboundTag || !SamePort(into.targetPort, rule.targetPort) || !SamePort(into.sourcePort, rule.sourcePort) ||
+            into.extraSettings != rule.extraSettings)
+            return false;
+
+        ConditionList differing = nullptr;
+        for (const auto list : ConditionLists)
+        {
+            if (into.*list == rule.*list)
+                continue;
+            if (differing || (into.*list).isEmpty() || (rule.*list).isEmpty())
+                return false;
+            differing = list;
+        }
+
+        if (differing)
+        {
+            into.*differing << rule.*differing;
+            DeduplicateList(into.*differing, IsIPList(differing));
+        }
+        return true;
+    }
+
+    void CompactRules(QList<RuleObject> &rules)
+    {
+        QList<RuleObject> result;
+        result.reserve(rules.size());
+
+        // Entries of earlier single-condition rules, a later rule can never be the first to match them.
+        QSet<QString> seen[ConditionListsCount];
+        PrefixSet seenPrefixes[ConditionListsCount];
+
+        for (auto &rule : rules)
+        {
+            for (const auto list : ConditionLists)
+                DeduplicateList(rule.*list, IsIPList(list));
+
+            if (const auto list = SingleCondition(rule); list)
+            {
+                const auto index = std::find(std::begin(ConditionLists), std::end(ConditionLists), list) - std::begin(ConditionLists);
+                auto &entries = rule.*list;
+                entries.removeIf([&](const QString &entry) { return seen[index].contains(entry) || (IsIPList(list) && seenPrefixes[index].Covers(entry)); });
+
+                // Every entry is shadowed.
+                if (entries.isEmpty())
+                    continue;
+
+                for (const auto &entry : entries)
+                {
+                    seen[index] << entry;
+                    // References and invalid entries are not prefixes, they are only shadowed by themselves.
+                    if (IsIPList(list))
+                        seenPrefixes[index].Insert(entry);
+                }
+            }
+
+            if (result.isEmpty() || !TryMerge(result.last(), rule))
+                result << std::move(rule);
+
+            // Both networks are matched, nothing after this rule is reachable.
+            const auto networksIndex = ConditionListsCount - 1;
+            if (seen[networksIndex].contains(u"tcp"_qs) && seen[networksIndex].contains(u"udp"_qs))
+                break;
+        }
+
+        rules = std::move(result);
+    }
+} // namespace Qv2ray::components::RouteOptimizer
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "QvPlugin/Common/CommonTypes.hpp"
+
+namespace Qv2ray::components::RouteOptimizer
+{
+    // Rewrites the rules into a smaller list which routes every connection to the same outbound:
+    // entries are deduplicated, consecutive rules differing in a single condition are merged,
+    // entries already matched by an earlier single-condition rule are dropped, and so is everything after a match-all rule.
+    void CompactRules(QList<RuleObject> &rules);
+} // namespace Qv2ray::components::RouteOptimizer
+
+using namespace Qv2ray::components::RouteOptimizer;
@@ -0,0 +1,423 @@
+#include "RouteSimulator.hpp"
+
+#include "components/GeositeReader/picoproto.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <optional>
+
+namespace Qv2ray::components::RouteSimulator
+{
+    // Domain types of geosite.dat, matching the routercommon protobuf definition.
+    enum DomainType
+    {
+        Plain = 0,
+        Regex = 1,
+        RootDomain = 2,
+        Full = 3,
+    };
+
+    // "geosite:cn", "geoip:cn" and "ext:file.dat:tag" references, returns the data file name and the tag.
+    static std::optional<std::pair<QString, QString>> ParseGeoReference(const QString &str, const QString &defaultFile)
+    {
+        if (str.startsWith(defaultFile.section(u'.', 0, 0) + u':'))
+            return std::pair{ defaultFile, str.section(u':', 1) };
+        if (str.startsWith(u"ext:"_qs))
+            return std::pair{ str.section(u':', 1, 1), str.section(u':', 2) };
+        return std::nullopt;
+    }
+
+    static bool InRange(const std::pair<int, int> &range, int value)
+    {
+        return range.first == 0 || range.second == 0 || (range.first <= value && value <= range.second);
+    }
+
+    void RouteSimulator::IPSet::Insert(const QHostAddress &addr, int prefix)
+    {
+        Address value;
+        int hostBits;
+        if (addr.protocol() == QAbstractSocket::IPv4Protocol)
+        {
+            value = { 0, addr.toIPv4Address() };
+            hostBits = 32 - std::clamp(prefix, 0, 32);
+        }
+        else
+        {
+            const auto ip = addr.toIPv6Address();
+            value = { 0, 0 };
+            for (auto i = 0; i < 8; i++)
+            {
+                value.first = value.first << 8 | ip[i];
+                value.second = value.second << 8 | ip[i + 8];
+            }
+            hostBits = 128 - std::clamp(prefix, 0, 128);
+        }
+
+        const Address mask{ hostBits >= 128 ? ~0ULL : hostBits > 64 ? (1ULL << (hostBits - 64)) - 1 : 0, //
+                            hostBits >= 64 ? ~0ULL : (1ULL << hostBits) - 1 };
+        auto &list = addr.protocol() == QAbstractSocket::IPv4Protocol ? v4 : v6;
+        list.append({ { value.first & ~mask.first, value.second & ~mask.second }, { value.first | mask.first, value.second | mask.second } });
+    }
+
+    void RouteSimulator::IPSet::Seal()
+    {
+        for (auto list : { &v4, &v6 })
+        {
+            std::sort(list->begin(), list->end());
+            QList<std::pair<Address, Address>> merged;
+            merged.reserve(list->size());
+            for (const auto &range : *list)
+            {
+                if (!merged.isEmpty() && range.first <= merged.last().second)
+                    merged.last().second = std::max(merged.last().second, range.second);
+                else
+                    merged.append(range);
+            }
+            *list = std::move(merged);
+        }
+    }
+
+    bool RouteSimulator::IPSet::Contains(const QHostAddress &addr) const
+    {
+        Address value{ 0, 0 };
+        const auto isV4 = addr.protocol() == QAbstractSocket::IPv4Protocol;
+        if (isV4)
+        {
+            value.second = addr.toIPv4Address();
+        }
+        else
+        {
+            const auto ip = addr.toIPv6Address();
+            for (auto i = 0; i < 8; i++)
+            {
+                value.first = value.first << 8 | ip[i];
+                value.second = value.second << 8 | ip[i + 8];
+            }
+        }
+
+        // The last range starting at or before the address is the only candidate.
+        const auto &list = isV4 ? v4 : v6;
+        auto it = std::upper_bound(list.cbegin(), list.cend(), value, [](const Address &v, const auto &range) { return v < range.first; });
+        return it != list.cbegin() && value <= (--it)->second;
+    }
+
+    bool RouteSimulator::IPCondition::Matches(const QHostAddress &addr) const
+    {
+        if (addr.isNull())
+            return false;
+        return ips.Contains(addr) || std::any_of(inverse.cbegin(), inverse.cend(), [&](const IPSet &set) { return !set.Contains(addr); });
+    }
+
+    bool RouteSimulator::DomainCondition::Matches(const QString &domain) const
+    {
+        if (domain.isEmpty())
+            return false;
+
+        if (full.contains(domain))
+            return true;
+
+        if (!suffixes.isEmpty())
+        {
+            // Try the domain itself and every parent domain.
+            qsizetype pos = 0;
+            while (true)
+            {
+                if (suffixes.contains(domain.mid(pos)))
+                    return true;
+                pos = domain.indexOf(u'.', pos);
+                if (pos < 0)
+                    break;
+                pos++;
+            }
+        }
+
+        for (const auto &keyword : keywords)
+        {
+            if (domain.contains(keyword))
+                return true;
+        }
+
+        for (const auto &regex : regexes)
+        {
+            if (regex.match(domain).hasMatch())
+                return true;
+        }
+        return false;
+    }
+
+    RouteSimulator::RouteSimulator(const ProfileContent &profile, const QString &assetsDir) : assetsDir(assetsDir)
+    {
+        domainStrategy = profile.routing.extraOptions[u"domainStrategy"_qs].toString();
+
+        QHash<QString, OutboundObject::ObjectType> outboundTypes;
+        for (const auto &out : profile.outbounds)
+        {
+            outboundTypes.insert(out.name, out.objectType);
+            // Only original outbounds become outbound handlers, the core defaults to the first one of them.
+            if (defaultOutbound.isEmpty() && out.objectType == OutboundObject::ORIGINAL)
+                defaultOutbound = out.name;
+        }
+
+        rules.reserve(profile.routing.rules.size());
+        for (qsizetype i = 0; i < profile.routing.rules.size(); i++)
+        {
+            const auto &r = profile.routing.rules[i];
+            Rule rule;
+            rule.index = i;
+            rule.outboundTag = r.outboundTag;
+            rule.isBalancer = outboundTypes.value(r.outboundTag, OutboundObject::ORIGINAL) == OutboundObject::BALANCER;
+
+            rule.domains.present = !r.targetDomains.isEmpty();
+            for (const auto &domain : r.targetDomains)
+            {
+                if (const auto ref = ParseGeoReference(domain, u"geosite.dat"_qs); ref)
+                    LoadDomains(rule.domains, ref->first, ref->second);
+                else if (domain.startsWith(u"regexp:"_qs))
+                    AddDomain(rule.domains, Regex, domain.mid(7));
+                else if (domain.startsWith(u"domain:"_qs))
+                    AddDomain(rule.domains, RootDomain, domain.mid(7));
+                else if (domain.startsWith(u"full:"_qs))
+                    AddDomain(rule.domains, Full, domain.mid(5));
+                else if (domain.startsWith(u"keyword:"_qs))
+                    AddDomain(rule.domains, Plain, domain.mid(8));
+                else
+                    AddDomain(rule.domains, Plain, domain);
+            }
+
+            CompileIPs(rule.ips, r.targetIPs);
+            CompileIPs(rule.sources, r.sourceAddresses);
+            rule.port = { r.targetPort.from, r.targetPort.to };
+            rule.sourcePort = { r.sourcePort.from, r.sourcePort.to };
+
+            for (const auto &network : r.networks)
+            {
+                // "tcp,udp" is accepted by the core as well.
+                for (const auto &n : network.split(u',', Qt::SkipEmptyParts))
+                    rule.networks << n.trimmed().toLower();
+            }
+            rule.inboundTags = { r.inboundTags.cbegin(), r.inboundTags.cend() };
+            rule.protocols = { r.protocols.cbegin(), r.protocols.cend() };
+            for (const auto &user : r.extraSettings[u"user"_qs].toArray())
+                rule.users << user.toString();
+
+            rules << std::move(rule);
+        }
+
+        geoFiles.clear();
+    }
+
+    picoproto::Message *RouteSimulator::LoadGeoFile(const QString &file)
+    {
+        if (const auto it = geoFiles.constFind(file); it != geoFiles.constEnd())
+            return it->get();
+
+        auto &message = geoFiles[file];
+        QFile f(QDir(assetsDir).filePath(file));
+        if (!f.open(QIODevice::ReadOnly))
+        {
+            errors << u"Cannot open data file: "_qs + f.fileName();
+            return nullptr;
+        }
+
+        // Entries are parsed lazily by picoproto, unreferenced ones cost nothing but the copy.
+        auto content = f.readAll();
+        message = std::make_shared<picoproto::Message>();
+        message->ParseFromBytes(reinterpret_cast<uint8_t *>(content.data()), content.size());
+        return message.get();
+    }
+
+    void RouteSimulator::AddDomain(DomainCondition &condition, int type, const QString &value)
+    {
+        switch (type)
+        {
+            case Plain: condition.keywords << value.toLower(); break;
+            case RootDomain: condition.suffixes << value.toLower(); break;
+            case Full: condition.full << value.toLower(); break;
+            case Regex:
+            {
+                QRegularExpression regex{ value };
+                if (!regex.isValid())
+                {
+                    errors << u"Invalid domain regex: "_qs + value;
+                    return;
+                }
+                regex.optimize();
+                condition.regexes << regex;
+                break;
+            }
+            default: errors << u"Unknown domain type %1: %2"_qs.arg(type).arg(value); break;
+        }
+    }
+
+    void RouteSimulator::LoadDomains(DomainCondition &condition, const QString &file, const QString &reference)
+    {
+        auto attributes = reference.split(u'@');
+        const auto code = attributes.takeFirst();
+
+        const auto root = LoadGeoFile(file);
+        if (!root)
+            return;
+
+        for (const auto site : root->GetMessageArray(1))
+        {
+            const auto codes = site->GetStringArray(1);
+            if (codes.empty() || QString::fromStdString(codes.front()).compare(code, Qt::CaseInsensitive) != 0)
+                continue;
+
+            for (const auto domain : site->GetMessageArray(2))
+            {
+                const auto hasAttribute = [domain](const QString &attr)
+                {
+                    const auto attrs = domain->GetMessageArray(3);
+                    return std::any_of(attrs.cbegin(), attrs.cend(),
+                                       [&](picoproto::Message *a)
+                                       {
+                                           const auto keys = a->GetStringArray(1);
+                                           return !keys.empty() && QString::fromStdString(keys.front()) == attr;
+                                       });
+                };
+                if (!std::all_of(attributes.cbegin(), attributes.cend(), hasAttribute))
+                    continue;
+
+                // Plain is the default value and therefore omitted from the encoded message.
+                const auto types = domain->GetUInt64Array(1);
+                const auto values = domain->GetStringArray(2);
+                AddDomain(condition, types.empty() ? Plain : int(types.front()), values.empty() ? QString{} : QString::fromStdString(values.front()));
+            }
+            return;
+        }
+        errors << u"Geosite entry not found: "_qs + file + u':' + reference;
+    }
+
+    void RouteSimulator::LoadIPs(IPCondition &condition, const QString &file, const QString &reference)
+    {
+        const auto inverse = reference.startsWith(u'!');
+        const auto code = inverse ? reference.mid(1) : reference;
+
+        const auto root = LoadGeoFile(file);
+        if (!root)
+            return;
+
+        for (const auto geoip : root->GetMessageArray(1))
+        {
+            const auto codes = geoip->GetStringArray(1);
+            if (codes.empty() || QString::fromStdString(codes.front()).compare(code, Qt::CaseInsensitive) != 0)
+                continue;
+
+            // The entry itself may be marked as inverted as well.
+            const auto flags = geoip->GetUInt64Array(3);
+            const auto inverted = inverse != (!flags.empty() && flags.front() != 0);
+
+            // Non-inverted entries share the set of plain addresses, which is sealed once the whole list is compiled.
+            auto &set = inverted ? condition.inverse.emplaceBack() : condition.ips;
+            for (const auto cidr : geoip->GetMessageArray(2))
+            {
+                const auto ips = cidr->GetByteArray(1);
+                const auto prefixes = cidr->GetUInt64Array(2);
+                if (ips.empty())
+                    continue;
+
+                QHostAddress addr;
+                const auto &[data, size] = ips.front();
+                if (size == 4)
+                    addr.setAddress(quint32(data[0]) << 24 | quint32(data[1]) << 16 | quint32(data[2]) << 8 | quint32(data[3]));
+                else if (size == 16)
+                    addr.setAddress(data);
+                else
+                    continue;
+                set.Insert(addr, prefixes.empty() ? 0 : int(prefixes.front()));
+            }
+
+            if (inverted)
+                set.Seal();
+            return;
+        }
+        errors << u"GeoIP entry not found: "_qs + file + u':' + reference;
+    }
+
+    void RouteSimulator::CompileIPs(IPCondition &condition, const QStringList &list)
+    {
+        condition.present = !list.isEmpty();
+        for (const auto &str : list)
+        {
+            if (const auto ref = ParseGeoReference(str, u"geoip.dat"_qs); ref)
+            {
+                LoadIPs(condition, ref->first, ref->second);
+                continue;
+            }
+
+            const auto subnet = str.contains(u'/') ? QHostAddress::parseSubnet(str) : QPair<QHostAddress, int>{ QHostAddress{ str }, 128 };
+            if (subnet.first.isNull() || subnet.second < 0)
+            {
+                errors << u"Invalid IP address or CIDR: "_qs + str;
+                continue;
+            }
+            condition.ips.Insert(subnet.first, subnet.second);
+        }
+        condition.ips.Seal();
+    }
+
+    const RouteSimulator::Rule *RouteSimulator::Match(const Context &ctx) const
+    {
+        const auto &q = ctx.query;
+        for (const auto &rule : rules)
+        {
+            // Conditions of a rule are combined with AND, empty ones match anything.
+            if (rule.domains.present && !rule.domains.Matches(ctx.domain))
+                continue;
+            if (rule.ips.present && !rule.ips.Matches(ctx.ip))
+                continue;
+            if (!InRange(rule.port, q.port))
+                continue;
+            if (rule.sources.present && !rule.sources.Matches(ctx.source))
+                continue;
+            if (!InRange(rule.sourcePort, q.sourcePort))
+                continue;
+            if (!rule.networks.isEmpty() && !rule.networks.contains(q.network.toLower()))
+                continue;
+            if (!rule.inboundTags.isEmpty() && !rule.inboundTags.contains(q.inboundTag))
+                continue;
+            if (!rule.protocols.isEmpty() && !rule.protocols.contains(q.protocol))
+                continue;
+            if (!rule.users.isEmpty() && !rule.users.contains(q.user))
+                continue;
+            return &rule;
+        }
+        return nullptr;
+    }
+
+    RouteDecision RouteSimulator::Route(const RouteQuery &query) const
+    {
+        Context ctx{ query, {}, QHostAddress{ query.target }, QHostAddress{ query.source } };
+        if (ctx.ip.isNull())
+        {
+            ctx.domain = query.target.toLower();
+            // The core resolves the domain as soon as an IP rule is evaluated.
+            if (domainStrategy == u"IPOnDemand"_qs)
+                ctx.ip = QHostAddress{ query.resolvedIP };
+        }
+
+        auto rule = Match(ctx);
+        // Otherwise the domain is only resolved, and the rules evaluated again, after nothing has matched.
+        if (!rule && domainStrategy == u"IPIfNonMatch"_qs && !ctx.domain.isEmpty() && ctx.ip.isNull())
+        {
+            ctx.ip = QHostAddress{ query.resolvedIP };
+            if (!ctx.ip.isNull())
+                rule = Match(ctx);
+        }
+
+        if (!rule)
+            return { defaultOutbound, false, -1 };
+        return { rule->outboundTag, rule->isBalancer, rule->index };
+    }
+
+    QList<RouteDecision> RouteSimulator::Route(const QList<RouteQuery> &queries) const
+    {
+        QList<RouteDecision> result;
+        result.reserve(queries.size());
+        for (const auto &query : queries)
+            result << Route(query);
+        return result;
+    }
+} // namespace Qv2ray::components::RouteSimulator
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "QvPlugin/Common/CommonTypes.hpp"
+
+#include <QHostAddress>
+#include <QRegularExpression>
+#include <QSet>
+#include <memory>
+
+namespace picoproto
+{
+    class Message;
+}
+
+namespace Qv2ray::components::RouteSimulator
+{
+    struct RouteQuery
+    {
+        // A domain name or an IP address.
+        QString target;
+        // What the domain resolves to, only used by IP rules under the IPIfNonMatch and IPOnDemand domain strategies.
+        QString resolvedIP;
+        int port = 0;
+        QString network = u"tcp"_qs;
+        QString source;
+        int sourcePort = 0;
+        QString inboundTag;
+        // The sniffed protocol, e.g. http, tls or bittorrent.
+        QString protocol;
+        QString user;
+    };
+
+    struct RouteDecision
+    {
+        QString outboundTag;
+        bool isBalancer = false;
+        // Index of the matching rule, -1 when the connection falls through to the first outbound.
+        qsizetype ruleIndex = -1;
+    };
+
+    // Evaluates the routing rules of a profile in the order and with the semantics of the core, without starting it.
+    // Rules are compiled once, so that large batches of queries can be answered cheaply.
+    class RouteSimulator
+    {
+      public:
+        // geosite:, geoip: and ext: references are read from the data files in assetsDir, only the referenced entries are kept.
+        RouteSimulator(const ProfileContent &profile, const QString &assetsDir);
+        RouteDecision Route(const RouteQuery &query) const;
+        QList<RouteDecision> Route(const QList<RouteQuery> &queries) const;
+        // Entries and references which cannot be matched, the core refuses to start with these.
+        QStringList Errors() const
+        {
+            return errors;
+        }
+
+      private:
+        // A 128-bit address, IPv4 addresses only use the low 32 bits.
+        using Address = std::pair<quint64, quint64>;
+
+        class IPSet
+        {
+          public:
+            void Insert(const QHostAddress &addr, int prefix);
+            // Sorts and merges the ranges, must be called before Contains.
+            void Seal();
+            bool Contains(const QHostAddress &addr) const;
+
+          private:
+            QList<std::pair<Address, Address>> v4;
+            QList<std::pair<Address, Address>> v6;
+        };
+
+        struct IPCondition
+        {
+            bool present = false;
+            IPSet ips;
+            // geoip:!code entries, each of them matches every address outside of its set.
+            QList<IPSet> inverse;
+            bool Matches(const QHostAddress &addr) const;
+        };
+
+        struct DomainCondition
+        {
+            bool present = false;
+            QSet<QString> full;
+            QSet<QString> suffixes;
+            QStringList keywords;
+            QList<QRegularExpression> regexes;
+            bool Matches(const QString &domain) const;
+        };
+
+        struct Rule
+        {
+            qsizetype index;
+            QString outboundTag;
+            bool isBalancer;
+            DomainCondition domains;
+            IPCondition ips;
+            IPCondition sources;
+            std::pair<int, int> port;
+            std::pair<int, int> sourcePort;
+            QSet<QString> networks;
+            QSet<QString> inboundTags;
+            QSet<QString> protocols;
+            QSet<QString> users;
+        };
+
+        struct Context
+        {
+            const RouteQuery &query;
+            QString domain;
+            QHostAddress ip;
+            QHostAddress source;
+        };
+
+      private:
+        picoproto::Message *LoadGeoFile(const QString &file);
+        void AddDomain(DomainCondition &condition, int type, const QString &value);
+        void LoadDomains(DomainCondition &condition, const QString &file, const QString &reference);
+        void LoadIPs(IPCondition &condition, const QString &file, const QString &reference);
+        void CompileIPs(IPCondition &condition, const QStringList &list);
+        const Rule *Match(const Context &ctx) const;
+
+      private:
+        QString assetsDir;
+        QString domainStrategy;
+        QString defaultOutbound;
+        QList<Rule> rules;
+        QStringList errors;
+        // Parsed data files, only kept while compiling the rules.
+        QHash<QString, std::shared_ptr<picoproto::Message>> geoFiles;
+    };
+} // namespace Qv2ray::components::RouteSimulator
+
+using namespace Qv2ray::components::RouteSimulator;
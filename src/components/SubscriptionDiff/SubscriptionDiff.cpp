@@ -0,0 +1,143 @@
+#include "SubscriptionDiff.hpp"
+
+#include "Qv2rayBase/Common/Utils.hpp"
+#include "Qv2rayBase/Profile/ProfileManager.hpp"
+#include "Qv2rayBase/Qv2rayBaseLibrary.hpp"
+
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMultiHash>
+#include <algorithm>
+
+namespace Qv2ray::components::SubscriptionDiff
+{
+    // Members are written in sorted key order and strings with their length, so that neither the key order of the JSON
+    // nor the content of a string can make two different values look the same. Null members count as absent.
+    static void AddCanonical(QCryptographicHash &hash, const QJsonValue &value)
+    {
+        const auto addString = [&hash](const QString &str)
+        {
+            const auto utf8 = str.toUtf8();
+            hash.addData(QByteArray::number(utf8.size()) + ':');
+            hash.addData(utf8);
+        };
+
+        switch (value.type())
+        {
+            case QJsonValue::Object:
+            {
+                const auto object = value.toObject();
+                auto keys = object.keys();
+                std::sort(keys.begin(), keys.end());
+                hash.addData(QByteArrayLiteral("{"));
+                for (const auto &key : std::as_const(keys))
+                {
+                    const auto member = object.value(key);
+                    if (member.isNull() || member.isUndefined())
+                        continue;
+                    addString(key);
+                    AddCanonical(hash, member);
+                }
+                hash.addData(QByteArrayLiteral("}"));
+                break;
+            }
+            case QJsonValue::Array:
+            {
+                hash.addData(QByteArrayLiteral("["));
+                for (const auto &item : value.toArray())
+                    AddCanonical(hash, item);
+                hash.addData(QByteArrayLiteral("]"));
+                break;
+            }
+            case QJsonValue::String:
+            {
+                hash.addData(QByteArrayLiteral("s"));
+                addString(value.toString());
+                break;
+            }
+            case QJsonValue::Double: hash.addData('d' + QByteArray::number(value.toDouble(), 'g', 17) + ';'); break;
+            case QJsonValue::Bool: hash.addData(value.toBool() ? QByteArrayLiteral("t") : QByteArrayLiteral("f")); break;
+            default: hash.addData(QByteArrayLiteral("n")); break;
+        }
+    }
+
+    QByteArray ContentHash(const ProfileContent &profile)
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        AddCanonical(hash, profile.toJson());
+        return hash.result();
+    }
+
+    SubscriptionDiffResult DiffSubscription(const GroupId &group, const QList<std::pair<QString, ProfileContent>> &connections)
+    {
+        SubscriptionDiffResult diff;
+
+        QMultiHash<QByteArray, ConnectionId> byHash;
+        QMultiHash<QString, ConnectionId> byName;
+        QHash<ConnectionId, QString> names;
+        const auto members = QvProfileManager->GetConnections(group);
+        byHash.reserve(members.size());
+        byName.reserve(members.size());
+        names.reserve(members.size());
+        for (const auto &id : members)
+        {
+            const auto name = GetDisplayName(id);
+            byHash.insert(ContentHash(QvProfileManager->GetConnection(id)), id);
+            byName.insert(name, id);
+            names.insert(id, name);
+        }
+
+        // Connections which are left after matching by content, with their index in the subscription.
+        QList<qsizetype> unmatched;
+        for (qsizetype i = 0; i < connections.size(); i++)
+        {
+            const auto &[name, profile] = connections.at(i);
+            const auto it = byHash.find(ContentHash(profile));
+            if (it == byHash.end())
+            {
+                unmatched << i;
+                continue;
+            }
+
+            const auto id = it.value();
+            byHash.erase(it);
+            byName.remove(names.value(id), id);
+            if (names.take(id) == name)
+                diff.unchanged++;
+            else
+                diff.renamed.append({ id, name });
+        }
+
+        for (const auto i : unmatched)
+        {
+            const auto &[name, profile] = connections.at(i);
+            const auto it = byName.find(name);
+            if (it == byName.end())
+            {
+                diff.added.append({ name, profile });
+                continue;
+            }
+
+            const auto id = it.value();
+            byName.erase(it);
+            names.remove(id);
+            diff.updated.append({ id, profile });
+        }
+
+        diff.removed = names.keys();
+        return diff;
+    }
+
+    void ApplySubscriptionDiff(const GroupId &group, const SubscriptionDiffResult &diff)
+    {
+        for (const auto &id : diff.removed)
+            QvProfileManager->RemoveFromGroup(id, group);
+        for (const auto &[id, name] : diff.renamed)
+            QvProfileManager->RenameConnection(id, name);
+        for (const auto &[id, profile] : diff.updated)
+            QvProfileManager->UpdateConnection(id, profile);
+        for (const auto &[name, profile] : diff.added)
+            QvProfileManager->CreateConnection(profile, name, group);
+    }
+} // namespace Qv2ray::components::SubscriptionDiff
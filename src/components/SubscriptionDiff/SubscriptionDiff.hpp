@@ -0,0 +1,34 @@
+#pragma once
+
+#include "QvPlugin/Common/CommonTypes.hpp"
+
+#include <QList>
+
+namespace Qv2ray::components::SubscriptionDiff
+{
+    // A stable hash of what a connection connects to. It does not depend on the name of the connection, nor on the key order of the JSON it was read from.
+    QByteArray ContentHash(const ProfileContent &profile);
+
+    struct SubscriptionDiffResult
+    {
+        QList<std::pair<QString, ProfileContent>> added;
+        // Connections matched by name whose content changed, they keep their ID, latency and traffic statistics.
+        QList<std::pair<ConnectionId, ProfileContent>> updated;
+        // Connections matched by content whose name changed.
+        QList<std::pair<ConnectionId, QString>> renamed;
+        QList<ConnectionId> removed;
+        qsizetype unchanged = 0;
+
+        bool isEmpty() const
+        {
+            return added.isEmpty() && updated.isEmpty() && renamed.isEmpty() && removed.isEmpty();
+        }
+    };
+
+    // Matches the decoded connections against the current members of the group, first by content, then by name.
+    SubscriptionDiffResult DiffSubscription(const GroupId &group, const QList<std::pair<QString, ProfileContent>> &connections);
+    // Touches only the connections in the diff.
+    void ApplySubscriptionDiff(const GroupId &group, const SubscriptionDiffResult &diff);
+} // namespace Qv2ray::components::SubscriptionDiff
+
+using namespace Qv2ray::components::SubscriptionDiff;
@@ -0,0 +1,108 @@
+#include "SubscriptionScheduler.hpp"
+
+#include "Qv2rayApplication.hpp"
+#include "Qv2rayBase/Profile/ProfileManager.hpp"
+#include "Qv2rayBase/Qv2rayBaseLibrary.hpp"
+
+#include <QRandomGenerator>
+#include <QUrl>
+#include <algorithm>
+
+constexpr auto SUBSCRIPTION_HOST_INTERVAL_MS = 2000;
+// A provider which never reports back must not hold its slot forever.
+constexpr auto SUBSCRIPTION_UPDATE_TIMEOUT_MS = 5 * 60 * 1000;
+
+namespace Qv2ray::components::SubscriptionScheduler
+{
+    SubscriptionScheduler::SubscriptionScheduler(QObject *parent) : QObject(parent)
+    {
+        dispatchTimer.setSingleShot(true);
+        connect(&dispatchTimer, &QTimer::timeout, this, &SubscriptionScheduler::Dispatch);
+        connect(&updater, &SubscriptionUpdater::SubscriptionUpdater::OnUpdateFinished, this, &SubscriptionScheduler::OnUpdateFinished);
+    }
+
+    void SubscriptionScheduler::Schedule(const GroupId &group, int jitterMs)
+    {
+        if (scheduled.contains(group) || running.contains(group))
+            return;
+        scheduled.insert(group);
+
+        const auto enqueue = [this, group]()
+        {
+            queue << group;
+            Dispatch();
+        };
+
+        if (jitterMs > 0)
+            QTimer::singleShot(QRandomGenerator::global()->bounded(jitterMs), this, enqueue);
+        else
+            enqueue();
+    }
+
+    void SubscriptionScheduler::Dispatch()
+    {
+        // Starting an update may finish another one synchronously, which lands here again.
+        if (dispatching)
+            return;
+        dispatching = true;
+
+        const auto maxConcurrent = std::max(1, *GlobalConfig->behaviorConfig->MaxConcurrentSubscriptionUpdates);
+        qint64 nextAllowed = -1;
+        for (qsizetype i = 0; i < queue.size() && running.size() < maxConcurrent;)
+        {
+            const auto group = queue.at(i);
+            const auto subscription = QvProfileManager->GetGroupObject(group).subscription_config;
+            // Fetchers without an address are limited on their own.
+            auto host = QUrl(subscription.address).host();
+            if (host.isEmpty())
+                host = group.toString();
+
+            const auto busy = std::any_of(running.cbegin(), running.cend(), [&host](const auto &update) { return update.host == host; });
+            if (busy)
+            {
+                i++;
+                continue;
+            }
+
+            if (const auto it = lastStarted.constFind(host); it != lastStarted.constEnd() && it->elapsed() < SUBSCRIPTION_HOST_INTERVAL_MS)
+            {
+                const auto wait = SUBSCRIPTION_HOST_INTERVAL_MS - it->elapsed();
+                nextAllowed = nextAllowed < 0 ? wait : std::min(nextAllowed, wait);
+                i++;
+                continue;
+            }
+
+            queue.removeAt(i);
+            scheduled.remove(group);
+            const auto serial = nextSerial++;
+            running.insert(group, { host, serial });
+
+            // Hosts which were last started before the interval no longer hold anything back.
+            lastStarted.removeIf([](decltype(lastStarted)::iterator it) { return it.value().elapsed() >= SUBSCRIPTION_HOST_INTERVAL_MS; });
+            lastStarted[host].start();
+
+            QTimer::singleShot(SUBSCRIPTION_UPDATE_TIMEOUT_MS, this,
+                               [this, group, serial]()
+                               {
+                                   if (const auto it = running.constFind(group); it != running.constEnd() && it->serial == serial)
+                                   {
+                                       qWarning() << "Subscription update timed out:" << group.toString();
+                                       OnUpdateFinished(group);
+                                   }
+                               });
+
+            updater.Update(group);
+        }
+
+        if (nextAllowed >= 0 && (!dispatchTimer.isActive() || dispatchTimer.remainingTime() > nextAllowed))
+            dispatchTimer.start(int(nextAllowed));
+
+        dispatching = false;
+    }
+
+    void SubscriptionScheduler::OnUpdateFinished(const GroupId &group)
+    {
+        if (running.remove(group))
+            Dispatch();
+    }
+} // namespace Qv2ray::components::SubscriptionScheduler
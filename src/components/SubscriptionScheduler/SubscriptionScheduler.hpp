@@ -0,0 +1,47 @@
+#pragma once
+
+#include "QvPlugin/Common/CommonTypes.hpp"
+#include "SubscriptionUpdater/SubscriptionUpdater.hpp"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+namespace Qv2ray::components::SubscriptionScheduler
+{
+    // Runs subscription updates concurrently, at most MaxConcurrentSubscriptionUpdates at a time. Updates of subscriptions
+    // on the same host never overlap and are started at least SUBSCRIPTION_HOST_INTERVAL_MS apart.
+    class SubscriptionScheduler : public QObject
+    {
+        Q_OBJECT
+      public:
+        explicit SubscriptionScheduler(QObject *parent = nullptr);
+        // The update starts after a random delay of up to jitterMs, so that subscriptions falling due together are spread out.
+        void Schedule(const GroupId &group, int jitterMs = 0);
+
+      private:
+        void Dispatch();
+        void OnUpdateFinished(const GroupId &group);
+
+      private:
+        struct RunningUpdate
+        {
+            QString host;
+            quint64 serial;
+        };
+
+        // Scheduled groups, including those still waiting for their delay.
+        QSet<GroupId> scheduled;
+        QList<GroupId> queue;
+        QHash<GroupId, RunningUpdate> running;
+        QHash<QString, QElapsedTimer> lastStarted;
+        QTimer dispatchTimer;
+        SubscriptionUpdater::SubscriptionUpdater updater;
+        quint64 nextSerial = 0;
+        bool dispatching = false;
+    };
+} // namespace Qv2ray::components::SubscriptionScheduler
+
+using namespace Qv2ray::components::SubscriptionScheduler;
@@ -0,0 +1,197 @@
+#include "SubscriptionUpdater.hpp"
+
+#include "Qv2rayBase/Common/Utils.hpp"
+#include "Qv2rayBase/Plugin/PluginAPIHost.hpp"
+#include "Qv2rayBase/Profile/ProfileManager.hpp"
+#include "Qv2rayBase/Qv2rayBaseLibrary.hpp"
+#include "QvPlugin/PluginInterface.hpp"
+#include "SubscriptionDiff/SubscriptionDiff.hpp"
+
+#include <QCoreApplication>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QSet>
+#include <QThreadPool>
+
+constexpr auto SUBSCRIPTION_FETCH_TIMEOUT_MS = 60 * 1000;
+
+using namespace Qv2rayPlugin;
+
+namespace Qv2ray::components::SubscriptionUpdater
+{
+    struct DecodedSubscription
+    {
+        QList<std::pair<QString, ProfileContent>> connections;
+        SubscriptionResult::result_type_t<SR_Tags> tags;
+    };
+
+    static bool MatchesKeywords(const QString &name, const QList<QString> &keywords, bool matchAll)
+    {
+        for (const auto &keyword : keywords)
+        {
+            if (name.contains(keyword) != matchAll)
+                return !matchAll;
+        }
+        return matchAll;
+    }
+
+    // Runs on the worker: links are deserialized here too, and the include and exclude filters of the group are applied.
+    static DecodedSubscription ReadResult(const SubscriptionResult &result, const SubscriptionConfigObject &subscription)
+    {
+        QList<QString> includeKeywords;
+        QList<QString> excludeKeywords;
+        for (const auto &keyword : subscription.includeKeywords)
+            if (!keyword.trimmed().isEmpty())
+                includeKeywords << keyword.trimmed();
+        for (const auto &keyword : subscription.excludeKeywords)
+            if (!keyword.trimmed().isEmpty())
+                excludeKeywords << keyword.trimmed();
+
+        DecodedSubscription decoded;
+        const auto add = [&](const QString &name, const ProfileContent &profile)
+        {
+            if (!includeKeywords.isEmpty() && !MatchesKeywords(name, includeKeywords, subscription.includeRelation == SubscriptionConfigObject::RELATION_AND))
+                return;
+            if (!excludeKeywords.isEmpty() && MatchesKeywords(name, excludeKeywords, subscription.excludeRelation == SubscriptionConfigObject::RELATION_AND))
+                return;
+            decoded.connections << std::pair{ name, profile };
+        };
+
+        for (const auto &link : result.GetValue<SR_Links>())
+        {
+            if (const auto outbound = QvPluginAPIHost->Outbound_Deserialize(link); outbound)
+                add(outbound->first, ProfileContent{ outbound->second });
+        }
+
+        const auto outbounds = result.GetValue<SR_OutboundObjects>();
+        for (auto it = outbounds.cbegin(); it != outbounds.cend(); ++it)
+        {
+            ProfileContent profile;
+            profile.outbounds << it.value();
+            add(it.key(), profile);
+        }
+
+        decoded.tags = result.GetValue<SR_Tags>();
+        return decoded;
+    }
+
+    static void Apply(const GroupId &group, const DecodedSubscription &decoded)
+    {
+        const auto diff = DiffSubscription(group, decoded.connections);
+        qInfo() << "Subscription update of" << group.toString() << ":" << diff.added.size() << "added," << diff.updated.size() << "updated," << diff.renamed.size()
+                << "renamed," << diff.removed.size() << "removed," << diff.unchanged << "unchanged.";
+        ApplySubscriptionDiff(group, diff);
+
+        // Tags are not part of the content, they are set where they differ.
+        for (const auto &id : QvProfileManager->GetConnections(group))
+        {
+            const auto it = decoded.tags.constFind(GetDisplayName(id));
+            if (it == decoded.tags.constEnd())
+                continue;
+
+            const auto current = QvProfileManager->GetConnectionObject(id).tags;
+            if (QSet<QString>(current.begin(), current.end()) != QSet<QString>(it->begin(), it->end()))
+                QvProfileManager->SetConnectionTags(id, *it);
+        }
+
+        // Records the update time of the group, as an update through the profile manager would.
+        QvProfileManager->IgnoreSubscriptionUpdate(group);
+    }
+
+    SubscriptionUpdater::SubscriptionUpdater(QObject *parent) : QObject(parent)
+    {
+    }
+
+    void SubscriptionUpdater::Update(const GroupId &group)
+    {
+        const auto subscription = QvProfileManager->GetGroupObject(group).subscription_config;
+        const auto &[plugin, info] = QvPluginAPIHost->Subscription_GetProviderInfo(subscription.providerId);
+        if (!plugin)
+        {
+            qWarning() << "No provider for subscription" << group.toString() << ":" << subscription.providerId.toString();
+            emit OnUpdateFinished(group);
+            return;
+        }
+
+        const std::shared_ptr<SubscriptionProvider> provider = info.Creator();
+        const QPointer<SubscriptionUpdater> self(this);
+
+        // Decoding and importing thousands of connections takes a while, only the diff is applied on this thread.
+        // The validators of the body are kept once it has been applied, a body which did not apply is fetched in full again.
+        const auto decode = [self, group, subscription, provider](std::function<SubscriptionResult()> run, const Validators &bodyValidators)
+        {
+            QThreadPool::globalInstance()->start(
+                [self, group, subscription, provider, run, bodyValidators]()
+                {
+                    const auto decoded = ReadResult(run(), subscription);
+                    QMetaObject::invokeMethod(
+                        QCoreApplication::instance(),
+                        [self, group, decoded, bodyValidators]()
+                        {
+                            if (!self)
+                                return;
+
+                            // An empty result is what a provider returns when it fails, it must not empty the group.
+                            if (decoded.connections.isEmpty())
+                            {
+                                qWarning() << "Subscription" << group.toString() << "decoded to no connection, the group is left as it is.";
+                                self->validators.remove(group);
+                            }
+                            else
+                            {
+                                Apply(group, decoded);
+                                if (bodyValidators.etag.isEmpty() && bodyValidators.lastModified.isEmpty())
+                                    self->validators.remove(group);
+                                else
+                                    self->validators.insert(group, bodyValidators);
+                            }
+                            emit self->OnUpdateFinished(group);
+                        },
+                        Qt::QueuedConnection);
+                });
+        };
+
+        // The provider fetches through the network helper of the plugin interface, which can neither send the validators nor
+        // report a 304. An unchanged body is answered by the payload cache of the provider instead.
+        if (info.mode == Subscription::Subscribe_FetcherAndDecoder)
+        {
+            decode([provider, subscription]() { return provider->FetchDecodeSubscription(subscription.providerSettings); }, {});
+            return;
+        }
+
+        QNetworkRequest request{ QUrl{ subscription.address } };
+        request.setTransferTimeout(SUBSCRIPTION_FETCH_TIMEOUT_MS);
+        if (const auto it = validators.constFind(group); it != validators.constEnd() && it->address == subscription.address)
+        {
+            if (!it->etag.isEmpty())
+                request.setRawHeader("If-None-Match", it->etag);
+            if (!it->lastModified.isEmpty())
+                request.setRawHeader("If-Modified-Since", it->lastModified);
+        }
+
+        const auto reply = network.get(request);
+        connect(reply, &QNetworkReply::finished, this,
+                [this, reply, group, address = subscription.address, provider, decode]()
+                {
+                    reply->deleteLater();
+                    if (reply->error() != QNetworkReply::NoError)
+                    {
+                        qWarning() << "Failed to fetch subscription" << group.toString() << ":" << reply->errorString();
+                        emit OnUpdateFinished(group);
+                        return;
+                    }
+
+                    // Only sent with the validators of the body the group was last updated from, which is still current.
+                    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+                    {
+                        qInfo() << "Subscription" << group.toString() << "is not modified.";
+                        QvProfileManager->IgnoreSubscriptionUpdate(group);
+                        emit OnUpdateFinished(group);
+                        return;
+                    }
+
+                    const Validators bodyValidators{ address, reply->rawHeader("ETag"), reply->rawHeader("Last-Modified") };
+                    decode([provider, data = reply->readAll()]() { return provider->DecodeSubscription(data); }, bodyValidators);
+                });
+    }
+} // namespace Qv2ray::components::SubscriptionUpdater
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "QvPlugin/Common/CommonTypes.hpp"
+
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QObject>
+
+namespace Qv2ray::components::SubscriptionUpdater
+{
+    // Fetches and decodes a subscription off the UI thread, then applies only what changed to its group, so that the
+    // connections which are still in the subscription keep their IDs, latency and traffic statistics.
+    class SubscriptionUpdater : public QObject
+    {
+        Q_OBJECT
+      public:
+        explicit SubscriptionUpdater(QObject *parent = nullptr);
+        void Update(const GroupId &group);
+
+      signals:
+        // Emitted once per update, whether it succeeded or not.
+        void OnUpdateFinished(const GroupId &group);
+
+      private:
+        // The validators of the last body applied to a group, sent back as If-None-Match and If-Modified-Since.
+        struct Validators
+        {
+            QString address;
+            QByteArray etag;
+            QByteArray lastModified;
+        };
+
+        QNetworkAccessManager network;
+        QHash<GroupId, Validators> validators;
+    };
+} // namespace Qv2ray::components::SubscriptionUpdater
+
+using namespace Qv2ray::components::SubscriptionUpdater;
@@ -48,8 +48,11 @@ namespace Qv2ray::Models
         Bindable<ProfileId> LastConnectedId;
         Bindable<QString> GeoIPPath;
         Bindable<QString> GeoSitePath;
-        QJS_COMPARE(Qv2rayBehaviorConfig, DefaultLatencyTestEngine, AutoConnectBehavior, QuietMode, AutoConnectProfileId, LastConnectedId, GeoIPPath, GeoSitePath)
-        QJS_JSON(P(DefaultLatencyTestEngine, AutoConnectBehavior, QuietMode, AutoConnectProfileId, LastConnectedId, GeoIPPath, GeoSitePath))
+        Bindable<int> MaxConcurrentSubscriptionUpdates{ 4 };
+        QJS_COMPARE(Qv2rayBehaviorConfig, DefaultLatencyTestEngine, AutoConnectBehavior, QuietMode, AutoConnectProfileId, LastConnectedId, GeoIPPath, GeoSitePath,
+                    MaxConcurrentSubscriptionUpdates)
+        QJS_JSON(P(DefaultLatencyTestEngine, AutoConnectBehavior, QuietMode, AutoConnectProfileId, LastConnectedId, GeoIPPath, GeoSitePath,
+                   MaxConcurrentSubscriptionUpdates))
     };
 
     struct ProtocolInboundBase
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Only linked into the benchmarks, it replaces the global operator new to count the allocations made through it. Qt
+// containers allocate their storage with malloc and are not counted, protobuf messages, QObjects and private Qt data are.
+quint64 AllocationCount();
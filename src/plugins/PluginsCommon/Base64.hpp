@@ -0,0 +1,197 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <array>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QV2RAY_BASE64_SSSE3
+#include <immintrin.h>
+#endif
+
+namespace Qv2ray::Base64
+{
+    constexpr quint8 BASE64_INVALID = 0xFF;
+
+    // Both the standard and the URL-safe alphabet.
+    constexpr auto DecodeTable = []()
+    {
+        std::array<quint8, 256> table{};
+        for (auto &v : table)
+            v = BASE64_INVALID;
+        for (auto c = 'A'; c <= 'Z'; c++)
+            table[quint8(c)] = quint8(c - 'A');
+        for (auto c = 'a'; c <= 'z'; c++)
+            table[quint8(c)] = quint8(c - 'a' + 26);
+        for (auto c = '0'; c <= '9'; c++)
+            table[quint8(c)] = quint8(c - '0' + 52);
+        table[quint8('+')] = table[quint8('-')] = 62;
+        table[quint8('/')] = table[quint8('_')] = 63;
+        return table;
+    }();
+
+#ifdef QV2RAY_BASE64_SSSE3
+    // Decodes 16 characters into 12 bytes, 16 bytes are stored. Returns false, writing nothing, if any character is not in an alphabet.
+    __attribute__((target("ssse3"))) inline bool DecodeBlockSSSE3(const char *src, char *dst)
+    {
+        const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        const auto upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+        const auto lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+        const auto digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+        const auto plus = _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('+')), _mm_cmpeq_epi8(in, _mm_set1_epi8('-')));
+        const auto slash = _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), _mm_cmpeq_epi8(in, _mm_set1_epi8('_')));
+
+        const auto valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit), _mm_or_si128(plus, slash));
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            return false;
+
+        // Each class is a single offset away from its 6-bit value.
+        auto values = _mm_and_si128(upper, _mm_sub_epi8(in, _mm_set1_epi8('A')));
+        values = _mm_or_si128(values, _mm_and_si128(lower, _mm_sub_epi8(in, _mm_set1_epi8('a' - 26))));
+        values = _mm_or_si128(values, _mm_and_si128(digit, _mm_add_epi8(in, _mm_set1_epi8(52 - '0'))));
+        values = _mm_or_si128(values, _mm_and_si128(plus, _mm_set1_epi8(62)));
+        values = _mm_or_si128(values, _mm_and_si128(slash, _mm_set1_epi8(63)));
+
+        // Pack 4 x 6 bits into 24 bits per 32-bit lane, then gather the 3 significant bytes of each lane in big-endian order.
+        const auto pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const auto lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        const auto packed = _mm_shuffle_epi8(lanes, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), packed);
+        return true;
+    }
+
+    inline bool HasSSSE3()
+    {
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    }
+#endif
+
+    // Decodes standard or URL-safe base64, with or without padding, in a single pass. Characters outside of
+    // the alphabets, such as line breaks, are skipped and decoding stops at the first '=', like QByteArray::fromBase64.
+    inline QByteArray Decode(QByteArrayView input)
+    {
+        // Leave room for the 16-byte stores of the vectorised path.
+        QByteArray result(input.size() * 3 / 4 + 16, Qt::Uninitialized);
+        auto dst = result.data();
+        const auto src = input.data();
+        const auto size = input.size();
+
+#ifdef QV2RAY_BASE64_SSSE3
+        const auto simd = HasSSSE3();
+#endif
+
+        quint32 acc = 0;
+        auto count = 0;
+        qsizetype i = 0;
+        while (i < size)
+        {
+#ifdef QV2RAY_BASE64_SSSE3
+            if (simd && count == 0 && size - i >= 16 && DecodeBlockSSSE3(src + i, dst))
+            {
+                i += 16;
+                dst += 12;
+                continue;
+            }
+#endif
+            const auto ch = src[i++];
+            const auto value = DecodeTable[quint8(ch)];
+            if (value == BASE64_INVALID)
+            {
+                if (ch == '=')
+                    break;
+                continue;
+            }
+
+            acc = acc << 6 | value;
+            if (++count == 4)
+            {
+                *dst++ = char(acc >> 16);
+                *dst++ = char(acc >> 8);
+                *dst++ = char(acc);
+                acc = 0;
+                count = 0;
+            }
+        }
+
+        // A trailing group of 2 or 3 characters carries 1 or 2 bytes.
+        if (count == 2)
+        {
+            *dst++ = char(acc >> 4);
+        }
+        else if (count == 3)
+        {
+            *dst++ = char(acc >> 10);
+            *dst++ = char(acc >> 2);
+        }
+
+        result.truncate(dst - result.data());
+        return result;
+    }
+
+    constexpr char EncodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Encodes standard, padded base64 into the output while the input is still arriving in pieces, so that a body can be
+    // encoded in the same pass that produces it.
+    class StreamEncoder
+    {
+      public:
+        explicit StreamEncoder(QByteArray &output) : output(output){};
+
+        void Feed(QByteArrayView input)
+        {
+            auto src = reinterpret_cast<const quint8 *>(input.data());
+            auto size = input.size();
+            while (pendingCount != 0 && size > 0)
+            {
+                pending = pending << 8 | *src++;
+                size--;
+                if (++pendingCount == 3)
+                    WriteGroup(pending, 4);
+            }
+
+            const auto groups = size / 3;
+            const auto offset = output.size();
+            output.resize(offset + groups * 4);
+            auto dst = output.data() + offset;
+            for (qsizetype i = 0; i < groups; i++, src += 3, dst += 4)
+            {
+                const quint32 group = src[0] << 16 | src[1] << 8 | src[2];
+                dst[0] = EncodeTable[group >> 18];
+                dst[1] = EncodeTable[group >> 12 & 0x3F];
+                dst[2] = EncodeTable[group >> 6 & 0x3F];
+                dst[3] = EncodeTable[group & 0x3F];
+            }
+
+            for (auto i = groups * 3; i < size; i++)
+            {
+                pending = pending << 8 | *src++;
+                pendingCount++;
+            }
+        }
+
+        void Finish()
+        {
+            if (pendingCount == 1)
+                WriteGroup(pending << 16, 2);
+            else if (pendingCount == 2)
+                WriteGroup(pending << 8, 3);
+        }
+
+      private:
+        // Writes the first characters of a 24-bit group and pads it to 4.
+        void WriteGroup(quint32 group, int characters)
+        {
+            for (auto i = 0; i < 4; i++)
+                output.append(i < characters ? EncodeTable[group >> (18 - 6 * i) & 0x3F] : '=');
+            pending = 0;
+            pendingCount = 0;
+        }
+
+      private:
+        QByteArray &output;
+        quint32 pending = 0;
+        int pendingCount = 0;
+    };
+} // namespace Qv2ray::Base64
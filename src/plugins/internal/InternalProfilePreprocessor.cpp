@@ -1,9 +1,12 @@
 #include "InternalProfilePreprocessor.hpp"
 
+#include "InternalPlugin.hpp"
 #include "Qv2rayApplication.hpp"
 #include "Qv2rayBase/Common/Utils.hpp"
 #include "Qv2rayBase/Profile/ProfileManager.hpp"
 #include "QvPlugin/Utils/QJsonIO.hpp"
+#include "components/IPListProcessor/IPListProcessor.hpp"
+#include "components/RouteOptimizer/RouteOptimizer.hpp"
 
 constexpr auto DNS_INTERCEPTION_OUTBOUND_TAG = "dns-out";
 constexpr auto DEFAULT_FREEDOM_OUTBOUND_TAG = "direct";
@@ -69,14 +72,22 @@ void ProcessRoutes(RoutingObject &root, bool ForceDirectConnection, bool bypassC
         }
         {
             // IP rules
-            if (!routeConfig.ips->block->isEmpty())
-                newRulesList << GenerateSingleRouteRule<RULE_IP>(routeConfig.ips->block, DEFAULT_BLACKHOLE_OUTBOUND_TAG);
+            const auto aggregate = [](const QStringList &ips)
+            {
+                const auto [entries, invalid] = AggregateIPList(ips);
+                if (!invalid.isEmpty())
+                    Qv2rayInternalPlugin::Log(u"Ignored invalid IP routing entries: "_qs + invalid.join(u", "_qs));
+                return entries;
+            };
 
-            if (!routeConfig.ips->proxy->isEmpty())
-                newRulesList << GenerateSingleRouteRule<RULE_IP>(routeConfig.ips->proxy, outTag);
+            if (const auto ips = aggregate(routeConfig.ips->block); !ips.isEmpty())
+                newRulesList << GenerateSingleRouteRule<RULE_IP>(ips, DEFAULT_BLACKHOLE_OUTBOUND_TAG);
 
-            if (!routeConfig.ips->direct->isEmpty())
-                newRulesList << GenerateSingleRouteRule<RULE_IP>(routeConfig.ips->direct, DEFAULT_FREEDOM_OUTBOUND_TAG);
+            if (const auto ips = aggregate(routeConfig.ips->proxy); !ips.isEmpty())
+                newRulesList << GenerateSingleRouteRule<RULE_IP>(ips, outTag);
+
+            if (const auto ips = aggregate(routeConfig.ips->direct); !ips.isEmpty())
+                newRulesList << GenerateSingleRouteRule<RULE_IP>(ips, DEFAULT_FREEDOM_OUTBOUND_TAG);
 
             if (bypassLAN)
                 newRulesList << GenerateSingleRouteRule<RULE_IP>({ "geoip:private" }, DEFAULT_FREEDOM_OUTBOUND_TAG);
@@ -87,7 +98,7 @@ void ProcessRoutes(RoutingObject &root, bool ForceDirectConnection, bool bypassC
     }
 
     newRulesList << root.rules;
-    root.rules = newRulesList;
+    root.rules = std::move(newRulesList);
 }
 
 ProfileContent InternalProfilePreprocessor::PreprocessProfile(const ProfileContent &p)
@@ -98,13 +109,18 @@ ProfileContent InternalProfilePreprocessor::PreprocessProfile(const ProfileConte
     if (!needGeneration)
         return p;
 
+    bool hasAddr1 = !GlobalConfig->inboundConfig->ListenAddress1->isEmpty();
+    bool hasAddr2 = !GlobalConfig->inboundConfig->ListenAddress2->isEmpty();
+
+    // Shares everything with the input until modified, reserve once so the lists detach a single time: one inbound per
+    // enabled protocol and listen address, the DNS, blackhole and freedom outbounds.
+    const auto protocols = int(GlobalConfig->inboundConfig->HasHTTP) + int(GlobalConfig->inboundConfig->HasSOCKS) + int(GlobalConfig->inboundConfig->HasDokodemoDoor);
     auto result = p;
+    result.inbounds.reserve(protocols * (int(hasAddr1) + int(hasAddr2)));
+    result.outbounds.reserve(result.outbounds.size() + 3);
     if (result.outbounds.first().name.isEmpty())
         result.outbounds.first().name = u"Default"_qs;
 
-    bool hasAddr1 = !GlobalConfig->inboundConfig->ListenAddress1->isEmpty();
-    bool hasAddr2 = !GlobalConfig->inboundConfig->ListenAddress2->isEmpty();
-
 #define AddInbound(PROTOCOL, _protocol, ...)                                                                                                                             \
     do                                                                                                                                                                   \
     {                                                                                                                                                                    \
@@ -212,5 +228,7 @@ ProfileContent InternalProfilePreprocessor::PreprocessProfile(const ProfileConte
             result.outbounds.append(freedom);
     }
 
+    CompactRules(result.routing.rules);
+
     return result;
 }
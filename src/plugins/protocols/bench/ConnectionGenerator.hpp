@@ -0,0 +1,208 @@
+#pragma once
+
+#include "V2RayModels.hpp"
+
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QUrl>
+
+// Generates connections with the settings the share links of their protocol carry, and malformed variations of links.
+// The same seed generates the same connections, so that a failure of the serializer test or the benchmark can be
+// reproduced.
+class ConnectionGenerator
+{
+  public:
+    explicit ConnectionGenerator(quint32 seed) : random(seed){};
+
+    // Reserved URL characters and non-ASCII text are what the encoders get wrong, they are over-represented on purpose.
+    QString Text(int maxLength)
+    {
+        static const auto characters = u"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-._~:/?#[]@!$&'()*+,;=% éß中文あ🚀"_qs.toUcs4();
+        QString text;
+        const auto length = random.bounded(maxLength + 1);
+        for (auto i = 0; i < length; i++)
+        {
+            const char32_t ch = characters[random.bounded(int(characters.size()))];
+            text += QString::fromUcs4(&ch, 1);
+        }
+        return text;
+    }
+
+    QString Host()
+    {
+        switch (random.bounded(4))
+        {
+            case 0: return u"%1.%2.%3.%4"_qs.arg(random.bounded(1, 256)).arg(random.bounded(256)).arg(random.bounded(256)).arg(random.bounded(1, 255));
+            case 1: return u"2001:db8::%1:%2"_qs.arg(random.bounded(0x10000), 0, 16).arg(random.bounded(0x10000), 0, 16);
+            case 2: return u"bücher-%1.example"_qs.arg(random.bounded(1000));
+            default: return u"node-%1.example.com"_qs.arg(random.bounded(100000));
+        }
+    }
+
+    // Spells the host the ways links in the wild do: in other cases, in its ACE form, with a trailing dot, partly
+    // percent-encoded, or as an IPv6 address with its zeros written out.
+    QString HostSpelling()
+    {
+        const auto host = Host();
+        switch (random.bounded(6))
+        {
+            case 0: return host.toUpper();
+            case 1: return QString::fromLatin1(QUrl::toAce(host));
+            case 2: return host.contains(u':') ? host : host + u'.';
+            case 3: return host.contains(u':') ? host.toUpper() : QString::fromLatin1(QUrl::toPercentEncoding(host, "."));
+            case 4: return host.contains(u':') ? QString(host).replace(u"::"_qs, u":0:0:0:"_qs) : host;
+            default: return host;
+        }
+    }
+
+    QString Uuid()
+    {
+        return u"%1-%2-4%3-a%4-%5"_qs //
+            .arg(random.generate(), 8, 16, QChar(u'0'))
+            .arg(random.bounded(0x10000), 4, 16, QChar(u'0'))
+            .arg(random.bounded(0x1000), 3, 16, QChar(u'0'))
+            .arg(random.bounded(0x1000), 3, 16, QChar(u'0'))
+            .arg(random.generate64() & Q_UINT64_C(0xFFFFFFFFFFFF), 12, 16, QChar(u'0'));
+    }
+
+    std::pair<QString, IOConnectionSettings> Connection(const QString &protocol)
+    {
+        using namespace Qv2ray::Models;
+
+        IOConnectionSettings connection;
+        connection.protocol = protocol;
+        connection.address = Host();
+        connection.port = random.bounded(1, 65536);
+
+        if (protocol == u"http"_qs || protocol == u"socks"_qs)
+        {
+            if (random.bounded(2))
+                connection.protocolSettings = IOProtocolSettings{ QJsonObject{ { u"user"_qs, Text(12) }, { u"pass"_qs, Text(12) } } };
+        }
+        else if (protocol == u"shadowsocks"_qs)
+        {
+            ShadowSocksClientObject server;
+            server.method = Pick(QList<QString>{ u"aes-128-gcm"_qs, u"aes-256-gcm"_qs, u"chacha20-ietf-poly1305"_qs });
+            server.password = Text(24);
+            connection.protocolSettings = IOProtocolSettings{ server.toJson() };
+        }
+        else if (protocol == u"trojan"_qs)
+        {
+            connection.protocolSettings = IOProtocolSettings{ QJsonObject{ { u"password"_qs, Text(24) } } };
+        }
+        else if (protocol == u"vmess"_qs)
+        {
+            VMessClientObject client;
+            client.id = Uuid();
+            connection.protocolSettings = IOProtocolSettings{ client.toJson() };
+            connection.streamSettings = IOStreamSettings{ Stream({ u"tcp"_qs, u"http"_qs, u"ws"_qs, u"kcp"_qs, u"quic"_qs }).toJson() };
+        }
+        else if (protocol == u"vless"_qs)
+        {
+            VLESSClientObject client;
+            client.id = Uuid();
+            connection.protocolSettings = IOProtocolSettings{ client.toJson() };
+            connection.streamSettings = IOStreamSettings{ Stream({ u"tcp"_qs, u"http"_qs, u"ws"_qs, u"kcp"_qs, u"quic"_qs, u"grpc"_qs }).toJson() };
+        }
+
+        // Surrounding spaces are not kept by every decoder.
+        return { Text(24).trimmed(), connection };
+    }
+
+    QList<std::pair<QString, IOConnectionSettings>> Connections(const QString &protocol, int count)
+    {
+        QList<std::pair<QString, IOConnectionSettings>> connections;
+        connections.reserve(count);
+        for (auto i = 0; i < count; i++)
+            connections << Connection(protocol);
+        return connections;
+    }
+
+    // The base64 JSON links which older clients share for VMess.
+    QString LegacyVMessLink(const QString &name, const IOConnectionSettings &connection)
+    {
+        const QJsonObject json{
+            { u"v"_qs, u"2"_qs },                                                   //
+            { u"ps"_qs, name },                                                     //
+            { u"add"_qs, connection.address },                                      //
+            { u"port"_qs, connection.port.from },                                   //
+            { u"id"_qs, connection.protocolSettings[u"id"_qs].toString() },         //
+            { u"aid"_qs, u"0"_qs },                                                 //
+            { u"net"_qs, Pick(QList<QString>{ u"tcp"_qs, u"ws"_qs, u"h2"_qs }) },   //
+            { u"host"_qs, Host() },                                                 //
+            { u"path"_qs, u'/' + Text(16) },                                        //
+            { u"tls"_qs, random.bounded(2) ? u"tls"_qs : u""_qs },
+        };
+        return u"vmess://"_qs + QString::fromLatin1(QJsonDocument(json).toJson(QJsonDocument::Compact).toBase64());
+    }
+
+    // Truncates, overwrites, inserts, removes and repeats a few bytes at a time, and sometimes a byte which is not valid UTF-8.
+    QByteArray Mutate(QByteArray data)
+    {
+        static const QByteArray special = QByteArrayLiteral("%@:/?#[]=&+-.,;'\" \\\t\r\n{}");
+        const auto count = random.bounded(1, 5);
+        for (auto i = 0; i < count && !data.isEmpty(); i++)
+        {
+            const auto pos = random.bounded(int(data.size()));
+            switch (random.bounded(6))
+            {
+                case 0: data.truncate(pos); break;
+                case 1: data[pos] = special[random.bounded(int(special.size()))]; break;
+                case 2: data.insert(pos, special[random.bounded(int(special.size()))]); break;
+                case 3: data.remove(pos, random.bounded(1, 9)); break;
+                case 4: data.insert(pos, data.mid(random.bounded(int(data.size())), random.bounded(1, 17))); break;
+                default: data[pos] = char(random.bounded(256)); break;
+            }
+        }
+        return data;
+    }
+
+  private:
+    template<typename T>
+    const T &Pick(const QList<T> &list)
+    {
+        return list[random.bounded(int(list.size()))];
+    }
+
+    // Fills the transport settings which the share links of the protocol carry, everything else is left at its default.
+    Qv2ray::Models::StreamSettingsObject Stream(const QList<QString> &networks)
+    {
+        Qv2ray::Models::StreamSettingsObject stream;
+        stream.network = Pick(networks);
+        stream.security = random.bounded(2) ? u"tls"_qs : u"none"_qs;
+        if (stream.security == u"tls"_qs)
+            stream.tlsSettings->serverName = Host();
+
+        if (stream.network == u"tcp"_qs)
+        {
+            stream.tcpSettings->header->type = random.bounded(2) ? u"http"_qs : u"none"_qs;
+        }
+        else if (stream.network == u"http"_qs)
+        {
+            stream.httpSettings->host->append(Host());
+            stream.httpSettings->path = u'/' + Text(16);
+        }
+        else if (stream.network == u"ws"_qs)
+        {
+            stream.wsSettings->headers->insert(u"Host"_qs, Host());
+            stream.wsSettings->path = u'/' + Text(16);
+        }
+        else if (stream.network == u"kcp"_qs)
+        {
+            stream.kcpSettings->seed = Text(12);
+            stream.kcpSettings->header->type = u"wechat-video"_qs;
+        }
+        else if (stream.network == u"quic"_qs)
+        {
+            stream.quicSettings->security = u"aes-128-gcm"_qs;
+            stream.quicSettings->key = Text(12);
+        }
+        else if (stream.network == u"grpc"_qs)
+        {
+            stream.grpcSettings->serviceName = Text(12);
+        }
+        return stream;
+    }
+
+    QRandomGenerator random;
+};
@@ -0,0 +1,94 @@
+#include "bench/ConnectionGenerator.hpp"
+#include "core/OutboundHandler.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+
+static void Log(const QString &message)
+{
+    QTextStream(stdout) << message << Qt::endl;
+}
+
+static double LinksPerSecond(qsizetype count, qint64 nsecs)
+{
+    return count * 1e9 / std::max<qint64>(nsecs, 1);
+}
+
+// Times the encoders and decoders of every protocol, one link at a time and in batches. Their correctness is checked
+// by SerializerTest, the same seed generates the same connections.
+static void RunBench(const BuiltinSerializer &serializer, quint32 seed, int connectionsPerProtocol)
+{
+    Log(u"Timing the share link codecs with seed %1."_qs.arg(seed));
+    ConnectionGenerator generator(seed);
+
+    QList<std::pair<QString, IOConnectionSettings>> allConnections;
+    for (const auto &protocol : serializer.SupportedProtocols())
+    {
+        const auto connections = generator.Connections(protocol, connectionsPerProtocol);
+        allConnections << connections;
+
+        QElapsedTimer timer;
+        timer.start();
+        QStringList links;
+        links.reserve(connections.size());
+        for (const auto &[name, connection] : connections)
+            links << serializer.Serialize(name, connection).value_or(QString{});
+        const auto serializeTime = timer.nsecsElapsed();
+
+        timer.restart();
+        for (const auto &link : links)
+            serializer.Deserialize(link);
+        const auto deserializeTime = timer.nsecsElapsed();
+
+        Log(u"%1: %2 links/s encoded, %3 links/s decoded."_qs //
+                .arg(protocol)
+                .arg(LinksPerSecond(links.size(), serializeTime), 0, 'f', 0)
+                .arg(LinksPerSecond(links.size(), deserializeTime), 0, 'f', 0));
+
+        if (protocol != u"vmess"_qs)
+            continue;
+
+        QStringList legacyLinks;
+        legacyLinks.reserve(connections.size());
+        for (const auto &[name, connection] : connections)
+            legacyLinks << generator.LegacyVMessLink(name, connection);
+
+        timer.restart();
+        for (const auto &link : legacyLinks)
+            serializer.Deserialize(link);
+        Log(u"vmess (legacy): %1 links/s decoded."_qs.arg(LinksPerSecond(legacyLinks.size(), timer.nsecsElapsed()), 0, 'f', 0));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto serialized = serializer.SerializeBatch(allConnections);
+    const auto serializeTime = timer.nsecsElapsed();
+
+    const auto links = QString::fromUtf8(serialized.links).split(u'\n', Qt::SkipEmptyParts);
+    timer.restart();
+    serializer.DeserializeBatch(links);
+    const auto deserializeTime = timer.nsecsElapsed();
+    Log(u"Batches: %1 links/s encoded, %2 links/s decoded."_qs //
+            .arg(LinksPerSecond(allConnections.size(), serializeTime), 0, 'f', 0)
+            .arg(LinksPerSecond(links.size(), deserializeTime), 0, 'f', 0));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Times the share link codecs on generated connections."_qs);
+    parser.addHelpOption();
+
+    const QCommandLineOption seedOption(u"seed"_qs, u"Seed of the generated connections, the same seed generates the same ones."_qs, u"seed"_qs, u"1"_qs);
+    const QCommandLineOption connectionsOption(u"connections"_qs, u"Number of connections per protocol."_qs, u"count"_qs, u"2000"_qs);
+    parser.addOptions({ seedOption, connectionsOption });
+    parser.process(app);
+
+    const BuiltinSerializer serializer;
+    RunBench(serializer, parser.value(seedOption).toUInt(), std::max(parser.value(connectionsOption).toInt(), 1));
+    return 0;
+}
@@ -1,25 +1,27 @@
 #include "OutboundHandler.hpp"
 
+#include "Base64.hpp"
 #include "QvPlugin/Utils/QJsonIO.hpp"
+#include "ShareLink.hpp"
 #include "V2RayModels.hpp"
 
 #include <QJsonDocument>
-#include <QUrl>
-#include <QUrlQuery>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
 
-static QString SafeBase64Decode(QString string)
-{
-    QByteArray ba = string.replace(QChar('-'), QChar('+')).replace(QChar('_'), QChar('/')).toUtf8();
-    return QByteArray::fromBase64(ba, QByteArray::Base64Option::OmitTrailingEquals);
-}
+constexpr auto DESERIALIZE_BATCH_CHUNK_SIZE = 128;
+// The usual length of a link, the batch buffers are allocated for this many bytes per connection up front.
+constexpr auto SERIALIZE_BATCH_LINK_SIZE_HINT = 192;
 
 using namespace Qv2rayPlugin;
 using namespace Qv2ray::Models;
 
-QString SerializeVLESS(const QString &name, const IOConnectionSettings &connection);
-QString SerializeVMess(const QString &name, const IOConnectionSettings &connection);
-QString SerializeSS(const QString &name, const IOConnectionSettings &connection);
-QString SerializeTrojan(const QString &name, const IOConnectionSettings &connection);
+bool SerializeVLESS(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection);
+bool SerializeVMess(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection);
+bool SerializeSS(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection);
+bool SerializeTrojan(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection);
 
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVLESS(const QString &link);
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVMess(const QString &link);
@@ -27,52 +29,93 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeSS(const QStr
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeOldVMess(const QString &link);
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeTrojan(const QString &link);
 
-std::optional<QString> BuiltinSerializer::Serialize(const QString &name, const IOConnectionSettings &outbound) const
+// Writes the link at the end of the writer's buffer, returns false, leaving a partial link behind, if there is no link for the outbound.
+static bool SerializeLink(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &outbound)
 {
     const auto protocol = outbound.protocol;
-    const auto out = outbound.protocolSettings;
-    const auto stream = outbound.streamSettings;
 
     if (protocol == u"http"_qs || protocol == u"socks"_qs)
     {
-        QUrl url;
-        url.setScheme(protocol);
-        url.setHost(outbound.address);
-        url.setPort(outbound.port.from);
-        if (out.contains(u"user"_qs))
-            url.setUserName(out[u"user"_qs].toString());
-        if (out.contains(u"pass"_qs))
-            url.setUserName(out[u"pass"_qs].toString());
-        return url.toString();
+        const auto out = outbound.protocolSettings;
+        const auto user = out[u"user"_qs].toString();
+        const auto pass = out[u"pass"_qs].toString();
+        writer.Begin(protocol.toLatin1());
+        if (!user.isEmpty() || !pass.isEmpty())
+            writer.UserInfo(user, pass);
+        writer.HostPort(outbound.address, outbound.port.from);
+        if (!name.isEmpty())
+            writer.Fragment(name);
+        return true;
     }
 
     if (protocol == u"vless"_qs)
-        return SerializeVLESS(name, outbound);
+        return SerializeVLESS(writer, name, outbound);
 
     if (protocol == u"vmess"_qs)
-        return SerializeVMess(name, outbound);
+        return SerializeVMess(writer, name, outbound);
 
     if (protocol == u"shadowsocks"_qs)
-        return SerializeSS(name, outbound);
+        return SerializeSS(writer, name, outbound);
 
     if (protocol == u"trojan"_qs)
-        return SerializeTrojan(name, outbound);
+        return SerializeTrojan(writer, name, outbound);
 
-    return std::nullopt;
+    return false;
+}
+
+std::optional<QString> BuiltinSerializer::Serialize(const QString &name, const IOConnectionSettings &outbound) const
+{
+    QByteArray link;
+    ShareLinkWriter writer(link);
+    if (!SerializeLink(writer, name, outbound))
+        return std::nullopt;
+    return QString::fromUtf8(link);
+}
+
+SerializedLinks BuiltinSerializer::SerializeBatch(const QList<std::pair<QString, IOConnectionSettings>> &connections) const
+{
+    SerializedLinks result;
+    result.links.reserve(connections.size() * SERIALIZE_BATCH_LINK_SIZE_HINT);
+    result.subscription.reserve(result.links.capacity() / 3 * 4 + 4);
+
+    ShareLinkWriter writer(result.links);
+    Qv2ray::Base64::StreamEncoder encoder(result.subscription);
+    for (const auto &[name, outbound] : connections)
+    {
+        const auto lineStart = result.links.size();
+        if (lineStart > 0)
+            result.links.append('\n');
+
+        if (!SerializeLink(writer, name, outbound))
+        {
+            result.links.truncate(lineStart);
+            result.skipped << name;
+            continue;
+        }
+
+        // The line is still in cache, encoding it right away saves a second pass over the whole buffer.
+        encoder.Feed(QByteArrayView(result.links).sliced(lineStart));
+    }
+    encoder.Finish();
+    return result;
 }
 
 std::optional<std::pair<QString, IOConnectionSettings>> BuiltinSerializer::Deserialize(const QString &link) const
 {
     if (link.startsWith(u"http://"_qs) || link.startsWith(u"socks://"_qs))
     {
-        const QUrl url{ link };
+        const auto utf8 = link.toUtf8();
+        const auto url = ShareLink::Parse(utf8);
+        if (!url)
+            return std::nullopt;
+
         IOConnectionSettings out;
-        out.protocol = url.scheme();
-        out.address = url.host();
-        out.port = url.port();
-        out.protocolSettings["user"] = url.userName();
-        out.protocolSettings["pass"] = url.password();
-        return std::make_pair(url.fragment(), out);
+        out.protocol = QString::fromUtf8(url->scheme);
+        out.address = url->Host();
+        out.port = url->port;
+        out.protocolSettings["user"] = url->UserName();
+        out.protocolSettings["pass"] = url->Password();
+        return std::make_pair(url->Fragment(), out);
     }
 
     if (link.startsWith(u"ss://"_qs))
@@ -90,6 +133,63 @@ std::optional<std::pair<QString, IOConnectionSettings>> BuiltinSerializer::Deser
     return std::nullopt;
 }
 
+QList<DeserializedLink> BuiltinSerializer::DeserializeBatch(const QStringList &links) const
+{
+    QList<DeserializedLink> results(links.size());
+    // Each chunk writes to its own slots, take the pointer once so that no thread ever detaches the list.
+    const auto data = results.data();
+    const auto prefixes = SupportedLinkPrefixes();
+
+    const auto decodeChunk = [&, this](qsizetype chunk)
+    {
+        const auto end = std::min(links.size(), (chunk + 1) * DESERIALIZE_BATCH_CHUNK_SIZE);
+        for (auto i = chunk * DESERIALIZE_BATCH_CHUNK_SIZE; i < end; i++)
+        {
+            const auto link = links[i].trimmed();
+            const auto scheme = link.section(u"://"_qs, 0, 0);
+            if (!link.contains(u"://"_qs) || !prefixes.contains(scheme))
+                data[i].error = u"Unsupported link type: "_qs + scheme;
+            else if (auto result = Deserialize(link); result)
+                std::tie(data[i].name, data[i].outbound) = std::move(*result);
+            else
+                data[i].error = u"Malformed %1 link"_qs.arg(scheme);
+        }
+    };
+
+    const auto chunks = (links.size() + DESERIALIZE_BATCH_CHUNK_SIZE - 1) / DESERIALIZE_BATCH_CHUNK_SIZE;
+    if (chunks <= 1)
+    {
+        if (chunks == 1)
+            decodeChunk(0);
+        return results;
+    }
+
+    // Workers and the calling thread take chunks until none is left. A worker which only starts after
+    // everything is done finds no chunk and returns, it never touches the (by then destroyed) locals.
+    struct BatchState
+    {
+        std::atomic<qsizetype> nextChunk = 0;
+        QSemaphore finishedChunks;
+    };
+    const auto state = std::make_shared<BatchState>();
+    const auto runChunks = [state, chunks, decodeChunk]()
+    {
+        for (auto chunk = state->nextChunk++; chunk < chunks; chunk = state->nextChunk++)
+        {
+            decodeChunk(chunk);
+            state->finishedChunks.release();
+        }
+    };
+
+    const auto workers = std::min<qsizetype>(chunks, QThreadPool::globalInstance()->maxThreadCount()) - 1;
+    for (auto i = 0; i < workers; i++)
+        QThreadPool::globalInstance()->start(runChunks);
+
+    runChunks();
+    state->finishedChunks.acquire(chunks);
+    return results;
+}
+
 std::optional<PluginIOBoundData> BuiltinSerializer::GetOutboundInfo(const IOConnectionSettings &) const
 {
     return std::nullopt;
@@ -100,48 +200,44 @@ bool BuiltinSerializer::SetOutboundInfo(IOConnectionSettings &, const PluginIOBo
     return true;
 }
 
-QString SerializeVLESS(const QString &name, const IOConnectionSettings &conn)
+bool SerializeVLESS(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &conn)
 {
     const auto out = conn.protocolSettings;
     const auto stream = conn.streamSettings;
-    QUrl url;
-    url.setFragment(QUrl::toPercentEncoding(name));
-    url.setScheme(u"vless"_qs);
-    url.setHost(conn.address);
-    url.setPort(conn.port.from);
-    url.setUserName(out[u"id"_qs].toString());
+    writer.Begin("vless");
+    writer.UserInfo(out[u"id"_qs].toString());
+    writer.HostPort(conn.address, conn.port.from);
 
     // -------- COMMON INFORMATION --------
-    QUrlQuery query;
     const auto enc = out[u"encryption"_qs].toString(u"none"_qs);
     if (enc != u"none"_qs)
-        query.addQueryItem(u"encryption"_qs, enc);
+        writer.QueryItem("encryption", enc);
 
     const auto network = QJsonIO::GetValue(stream, "network").toString(u"tcp"_qs);
     if (network != u"tcp"_qs)
-        query.addQueryItem(u"type"_qs, network);
+        writer.QueryItem("type", network);
 
     const auto security = QJsonIO::GetValue(stream, "security").toString(u"none"_qs);
     if (security != u"none"_qs)
-        query.addQueryItem(u"security"_qs, security);
+        writer.QueryItem("security", security);
 
     // -------- TRANSPORT RELATED --------
     if (network == u"kcp"_qs)
     {
         const auto seed = QJsonIO::GetValue(stream, { "kcpSettings", "seed" }).toString();
         if (!seed.isEmpty())
-            query.addQueryItem(u"seed"_qs, QUrl::toPercentEncoding(seed));
+            writer.QueryItem("seed", seed);
 
         const auto headerType = QJsonIO::GetValue(stream, { "kcpSettings", "header", "type" }).toString(u"none"_qs);
         if (headerType != u"none"_qs)
-            query.addQueryItem(u"headerType"_qs, headerType);
+            writer.QueryItem("headerType", headerType);
     }
     else if (network == u"http"_qs)
     {
-        const auto path = QJsonIO::GetValue(stream, { "HTTPConfig", "path" }).toString(u"/"_qs);
-        query.addQueryItem(u"path"_qs, QUrl::toPercentEncoding(path));
+        const auto path = QJsonIO::GetValue(stream, { "httpSettings", "path" }).toString(u"/"_qs);
+        writer.QueryItem("path", path);
 
-        const auto hosts = QJsonIO::GetValue(stream, { "HTTPConfig", "host" }).toArray();
+        const auto hosts = QJsonIO::GetValue(stream, { "httpSettings", "host" }).toArray();
         QStringList hostList;
         for (const auto item : hosts)
         {
@@ -149,43 +245,45 @@ QString SerializeVLESS(const QString &name, const IOConnectionSettings &conn)
             if (!host.isEmpty())
                 hostList << host;
         }
-        query.addQueryItem(u"host"_qs, QUrl::toPercentEncoding(hostList.join(u","_qs)));
+        if (!hostList.isEmpty())
+            writer.QueryItem("host", hostList.join(u","_qs));
     }
     else if (network == u"ws"_qs)
     {
         const auto path = QJsonIO::GetValue(stream, { "wsSettings", "path" }).toString(u"/"_qs);
-        query.addQueryItem(u"path"_qs, QUrl::toPercentEncoding(path));
+        writer.QueryItem("path", path);
 
         const auto host = QJsonIO::GetValue(stream, { "wsSettings", "headers", "Host" }).toString();
-        query.addQueryItem(u"host"_qs, host);
+        if (!host.isEmpty())
+            writer.QueryItem("host", host);
     }
     else if (network == u"quic"_qs)
     {
         const auto quicSecurity = QJsonIO::GetValue(stream, { "quicSettings", "security" }).toString(u"none"_qs);
         if (quicSecurity != u"none"_qs)
         {
-            query.addQueryItem(u"quicSecurity"_qs, quicSecurity);
+            writer.QueryItem("quicSecurity", quicSecurity);
 
             const auto key = QJsonIO::GetValue(stream, { "quicSettings", "key" }).toString();
-            query.addQueryItem(u"key"_qs, QUrl::toPercentEncoding(key));
+            writer.QueryItem("key", key);
 
             const auto headerType = QJsonIO::GetValue(stream, { "quicSettings", "header", "type" }).toString(u"none"_qs);
             if (headerType != u"none"_qs)
-                query.addQueryItem(u"headerType"_qs, headerType);
+                writer.QueryItem("headerType", headerType);
         }
     }
     else if (network == u"grpc"_qs)
     {
         const auto serviceName = QJsonIO::GetValue(stream, { "grpcSettings", "serviceName" }).toString(u"GunService"_qs);
         if (serviceName != u"GunService"_qs)
-            query.addQueryItem(u"serviceName"_qs, QUrl::toPercentEncoding(serviceName));
+            writer.QueryItem("serviceName", serviceName);
     }
     // -------- TLS RELATED --------
     const auto tlsKey = security == u"xtls"_qs ? "xtlsSettings" : "tlsSettings";
 
     const auto sni = QJsonIO::GetValue(stream, { tlsKey, "serverName" }).toString();
     if (!sni.isEmpty())
-        query.addQueryItem(u"sni"_qs, sni);
+        writer.QueryItem("sni", sni);
 
     // ALPN
     const auto alpnArray = QJsonIO::GetValue(stream, { tlsKey, u"alpn"_qs }).toArray();
@@ -196,21 +294,23 @@ QString SerializeVLESS(const QString &name, const IOConnectionSettings &conn)
         if (!alpn.isEmpty())
             alpnList << alpn;
     }
-    query.addQueryItem(u"alpn"_qs, QUrl::toPercentEncoding(alpnList.join(u","_qs)));
+    if (!alpnList.isEmpty())
+        writer.QueryItem("alpn", alpnList.join(u","_qs));
 
     // -------- XTLS Flow --------
     if (security == u"xtls"_qs)
     {
         const auto flow = out[u"flow"_qs].toString();
-        query.addQueryItem(u"flow"_qs, flow);
+        writer.QueryItem("flow", flow);
     }
 
     // ======== END OF QUERY ========
-    url.setQuery(query);
-    return url.toString(QUrl::FullyEncoded);
+    if (!name.isEmpty())
+        writer.Fragment(name);
+    return true;
 }
 
-QString SerializeVMess(const QString &alias, const IOConnectionSettings &connection)
+bool SerializeVMess(ShareLinkWriter &writer, const QString &alias, const IOConnectionSettings &connection)
 {
     Qv2ray::Models::VMessClientObject server;
     server.loadJson(connection.protocolSettings);
@@ -218,103 +318,105 @@ QString SerializeVMess(const QString &alias, const IOConnectionSettings &connect
     Qv2ray::Models::StreamSettingsObject stream;
     stream.loadJson(connection.streamSettings);
 
-    QUrl url;
-    QUrlQuery query;
-    url.setFragment(alias, QUrl::StrictMode);
+    static const QStringList supportedNetworks{ u"tcp"_qs, u"http"_qs, u"ws"_qs, u"kcp"_qs, u"quic"_qs };
+    if (!supportedNetworks.contains(*stream.network))
+        return false;
+
+    bool hasTLS = stream.security == u"tls"_qs;
+    auto protocol = *stream.network;
+    if (hasTLS)
+        protocol += u"+tls"_qs;
+
+    writer.Begin("vmess");
+    writer.UserInfo(protocol, server.id + "-0");
+    writer.HostPort(connection.address, connection.port.from);
+    writer.Path("/");
 
     if (stream.network == u"tcp"_qs)
     {
         if (!stream.tcpSettings->header->type->isEmpty() && stream.tcpSettings->header->type != u"none"_qs)
-            query.addQueryItem(u"type"_qs, stream.tcpSettings->header->type);
+            writer.QueryItem("type", stream.tcpSettings->header->type);
     }
     else if (stream.network == u"http"_qs)
     {
         if (!stream.httpSettings->host->isEmpty())
-            query.addQueryItem(u"host"_qs, stream.httpSettings->host->first());
-        query.addQueryItem(u"path"_qs, stream.httpSettings->path->isEmpty() ? u"/"_qs : *stream.httpSettings->path);
+            writer.QueryItem("host", stream.httpSettings->host->first());
+        writer.QueryItem("path", stream.httpSettings->path->isEmpty() ? u"/"_qs : *stream.httpSettings->path);
     }
     else if (stream.network == u"ws"_qs)
     {
         if (stream.wsSettings->headers->contains(u"Host"_qs) && !stream.wsSettings->headers->value(u"Host"_qs).isEmpty())
-            query.addQueryItem(u"host"_qs, stream.wsSettings->headers->value(u"Host"_qs));
+            writer.QueryItem("host", stream.wsSettings->headers->value(u"Host"_qs));
         if (!stream.wsSettings->path->isEmpty() && stream.wsSettings->path != u"/"_qs)
-            query.addQueryItem(u"path"_qs, stream.wsSettings->path);
+            writer.QueryItem("path", stream.wsSettings->path);
     }
     else if (stream.network == u"kcp"_qs)
     {
         if (!stream.kcpSettings->seed->isEmpty())
-            query.addQueryItem(u"seed"_qs, stream.kcpSettings->seed);
+            writer.QueryItem("seed", stream.kcpSettings->seed);
         if (!stream.kcpSettings->header->type->isEmpty() && stream.kcpSettings->header->type != u"none"_qs)
-            query.addQueryItem(u"type"_qs, stream.kcpSettings->header->type);
+            writer.QueryItem("type", stream.kcpSettings->header->type);
     }
     else if (stream.network == u"quic"_qs)
     {
         if (!stream.quicSettings->security->isEmpty() && stream.quicSettings->security != u"none"_qs)
-            query.addQueryItem(u"security"_qs, stream.quicSettings->security);
+            writer.QueryItem("security", stream.quicSettings->security);
         if (!stream.quicSettings->key->isEmpty())
-            query.addQueryItem(u"key"_qs, stream.quicSettings->key);
+            writer.QueryItem("key", stream.quicSettings->key);
         if (!stream.quicSettings->header->type->isEmpty() && stream.quicSettings->header->type != u"none"_qs)
-            query.addQueryItem(u"headers"_qs, stream.quicSettings->header->type);
-    }
-    else
-    {
-        return {};
+            writer.QueryItem("headers", stream.quicSettings->header->type);
     }
-    bool hasTLS = stream.security == u"tls"_qs;
-    auto protocol = *stream.network;
+
     if (hasTLS)
     {
         // if (stream.tlsSettings.allowInsecure)
         //    query.addQueryItem("allowInsecure", "true");
         if (!stream.tlsSettings->serverName->isEmpty())
-            query.addQueryItem(u"tlsServerName"_qs, stream.tlsSettings->serverName);
-        protocol += u"+tls"_qs;
+            writer.QueryItem("tlsServerName", stream.tlsSettings->serverName);
     }
-    url.setPath(u"/"_qs);
-    url.setScheme(u"vmess"_qs);
-    url.setPassword(server.id + "-0");
-    url.setHost(connection.address);
-    url.setPort(connection.port.from);
-    url.setUserName(protocol);
-    url.setQuery(query);
-    return url.toString();
+
+    if (!alias.isEmpty())
+        writer.Fragment(alias);
+    return true;
 }
 
-QString SerializeSS(const QString &name, const IOConnectionSettings &connection)
+bool SerializeSS(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection)
 {
     Qv2ray::Models::ShadowSocksClientObject server;
     server.loadJson(connection.protocolSettings);
-    QUrl url;
     const auto plainUserInfo = server.method + ":" + server.password;
     const auto userinfo = plainUserInfo.toUtf8().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
-    url.setUserInfo(userinfo);
-    url.setScheme(u"ss"_qs);
-    url.setHost(connection.address);
-    url.setPort(connection.port.from);
-    url.setFragment(name);
-    return url.toString(QUrl::ComponentFormattingOption::FullyEncoded);
+    writer.Begin("ss");
+    writer.UserInfo(QString::fromLatin1(userinfo));
+    writer.HostPort(connection.address, connection.port.from);
+    if (!name.isEmpty())
+        writer.Fragment(name);
+    return true;
 }
 
-QString SerializeTrojan(const QString &name, const IOConnectionSettings &connection)
+bool SerializeTrojan(ShareLinkWriter &writer, const QString &name, const IOConnectionSettings &connection)
 {
-    QUrl url;
-    url.setScheme(u"trojan"_qs);
-    url.setHost(connection.address);
-    url.setPort(connection.port.from);
-    url.setUserInfo(connection.protocolSettings[u"password"_qs].toString());
-    url.setFragment(name);
-    return url.toString();
+    writer.Begin("trojan");
+    writer.UserInfo(connection.protocolSettings[u"password"_qs].toString());
+    writer.HostPort(connection.address, connection.port.from);
+    if (!name.isEmpty())
+        writer.Fragment(name);
+    return true;
 }
 
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeTrojan(const QString &link)
 {
-    QUrl url{ link };
+    const auto utf8 = link.toUtf8();
+    const auto url = ShareLink::Parse(utf8);
+    if (!url)
+        return std::nullopt;
+
     IOConnectionSettings conn;
-    conn.address = url.host();
-    conn.port = url.port();
+    conn.address = url->Host();
+    conn.port = url->port;
     conn.protocol = u"trojan"_qs;
-    conn.protocolSettings.insert(u"password"_qs, url.userInfo());
-    return std::make_pair(QUrlQuery{ url.query() }.queryItemValue(u"password"_qs), conn);
+    conn.protocolSettings.insert(u"password"_qs, url->UserInfo());
+    return std::make_pair(url->Fragment(), conn);
 }
 
 const static QStringList NetworkType{ "tcp", "http", "ws", "kcp", "quic" };
@@ -325,27 +427,26 @@ const static QStringList FalseTypes{ "false", "False", "No", "Off", "0" };
 std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVLESS(const QString &link)
 {
     // parse url
-    QUrl url(link);
-    if (!url.isValid())
+    const auto utf8 = link.toUtf8();
+    const auto url = ShareLink::Parse(utf8);
+    if (!url)
         return std::nullopt;
 
-    // fetch host
-    const auto hostRaw = url.host();
-    if (hostRaw.isEmpty())
+    // fetch host, IPv6 brackets are already stripped
+    const auto host = url->Host();
+    if (host.isEmpty())
         return std::nullopt;
 
-    const auto host = (hostRaw.startsWith('[') && hostRaw.endsWith(']')) ? hostRaw.mid(1, hostRaw.length() - 2) : hostRaw;
-
     // fetch port
-    const auto port = url.port();
+    const auto port = url->port;
     if (port == -1)
         return std::nullopt;
 
     // fetch remarks
-    const auto remarks = url.fragment();
+    const auto remarks = url->Fragment();
 
     // fetch uuid
-    const auto uuid = url.userInfo();
+    const auto uuid = url->UserInfo();
     if (uuid.isEmpty())
         return std::nullopt;
 
@@ -355,85 +456,82 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVLESS(const Q
 
     outbound[u"id"_qs] = uuid;
 
-    // parse query
-    QUrlQuery query(url.query());
-
     // handle type
-    const auto hasType = query.hasQueryItem(u"type"_qs);
-    const auto type = hasType ? query.queryItemValue(u"type"_qs) : u"tcp"_qs;
+    const auto hasType = url->HasQueryItem("type");
+    const auto type = hasType ? url->QueryItemValue("type") : u"tcp"_qs;
     if (type != u"tcp"_qs)
         QJsonIO::SetValue(stream, type, u"network"_qs);
 
     // handle encryption
-    const auto hasEncryption = query.hasQueryItem(u"encryption"_qs);
-    const auto encryption = hasEncryption ? query.queryItemValue(u"encryption"_qs) : u"none"_qs;
+    const auto hasEncryption = url->HasQueryItem("encryption");
+    const auto encryption = hasEncryption ? url->QueryItemValue("encryption") : u"none"_qs;
     outbound[u"encryption"_qs] = encryption;
 
     // type-wise settings
     if (type == u"kcp"_qs)
     {
-        const auto hasSeed = query.hasQueryItem(u"seed"_qs);
+        const auto hasSeed = url->HasQueryItem("seed");
         if (hasSeed)
-            QJsonIO::SetValue(stream, query.queryItemValue(u"seed"_qs), { u"kcpSettings"_qs, u"seed"_qs });
+            QJsonIO::SetValue(stream, url->QueryItemValue("seed"), { u"kcpSettings"_qs, u"seed"_qs });
 
-        const auto hasHeaderType = query.hasQueryItem(u"headerType"_qs);
-        const auto headerType = hasHeaderType ? query.queryItemValue(u"headerType"_qs) : u"none"_qs;
+        const auto hasHeaderType = url->HasQueryItem("headerType");
+        const auto headerType = hasHeaderType ? url->QueryItemValue("headerType") : u"none"_qs;
         if (headerType != u"none"_qs)
             QJsonIO::SetValue(stream, headerType, { u"kcpSettings"_qs, u"header"_qs, u"type"_qs });
     }
     else if (type == u"http"_qs)
     {
-        const auto hasPath = query.hasQueryItem(u"path"_qs);
-        const auto path = hasPath ? QUrl::fromPercentEncoding(query.queryItemValue(u"path"_qs).toUtf8()) : u"/"_qs;
+        const auto hasPath = url->HasQueryItem("path");
+        const auto path = hasPath ? url->QueryItemValue("path") : u"/"_qs;
         if (path != u"/"_qs)
             QJsonIO::SetValue(stream, path, { u"httpSettings"_qs, u"path"_qs });
 
-        const auto hasHost = query.hasQueryItem(u"host"_qs);
+        const auto hasHost = url->HasQueryItem("host");
         if (hasHost)
         {
-            const auto hosts = QJsonArray::fromStringList(query.queryItemValue(u"host"_qs).split(','));
+            const auto hosts = QJsonArray::fromStringList(url->QueryItemValue("host").split(','));
             QJsonIO::SetValue(stream, hosts, { u"httpSettings"_qs, u"host"_qs });
         }
     }
     else if (type == u"ws"_qs)
     {
-        const auto hasPath = query.hasQueryItem(u"path"_qs);
-        const auto path = hasPath ? QUrl::fromPercentEncoding(query.queryItemValue(u"path"_qs).toUtf8()) : u"/"_qs;
+        const auto hasPath = url->HasQueryItem("path");
+        const auto path = hasPath ? url->QueryItemValue("path") : u"/"_qs;
         if (path != u"/"_qs)
             QJsonIO::SetValue(stream, path, { u"wsSettings"_qs, u"path"_qs });
 
-        const auto hasHost = query.hasQueryItem(u"host"_qs);
+        const auto hasHost = url->HasQueryItem("host");
         if (hasHost)
         {
-            QJsonIO::SetValue(stream, query.queryItemValue(u"host"_qs), { u"wsSettings"_qs, u"headers"_qs, u"Host"_qs });
+            QJsonIO::SetValue(stream, url->QueryItemValue("host"), { u"wsSettings"_qs, u"headers"_qs, u"Host"_qs });
         }
     }
     else if (type == u"quic"_qs)
     {
-        const auto hasQuicSecurity = query.hasQueryItem(u"quicSecurity"_qs);
+        const auto hasQuicSecurity = url->HasQueryItem("quicSecurity");
         if (hasQuicSecurity)
         {
-            const auto quicSecurity = query.queryItemValue(u"quicSecurity"_qs);
+            const auto quicSecurity = url->QueryItemValue("quicSecurity");
             QJsonIO::SetValue(stream, quicSecurity, { u"quicSettings"_qs, u"security"_qs });
 
             if (quicSecurity != u"none"_qs)
             {
-                const auto key = query.queryItemValue(u"key"_qs);
+                const auto key = url->QueryItemValue("key");
                 QJsonIO::SetValue(stream, key, { u"quicSettings"_qs, u"key"_qs });
             }
 
-            const auto hasHeaderType = query.hasQueryItem(u"headerType"_qs);
-            const auto headerType = hasHeaderType ? query.queryItemValue(u"headerType"_qs) : u"none"_qs;
+            const auto hasHeaderType = url->HasQueryItem("headerType");
+            const auto headerType = hasHeaderType ? url->QueryItemValue("headerType") : u"none"_qs;
             if (headerType != u"none"_qs)
                 QJsonIO::SetValue(stream, headerType, { u"quicSettings"_qs, u"header"_qs, u"type"_qs });
         }
     }
     else if (type == u"grpc"_qs)
     {
-        const auto hasServiceName = query.hasQueryItem(u"serviceName"_qs);
+        const auto hasServiceName = url->HasQueryItem("serviceName");
         if (hasServiceName)
         {
-            const auto serviceName = QUrl::fromPercentEncoding(query.queryItemValue(u"serviceName"_qs).toUtf8());
+            const auto serviceName = url->QueryItemValue("serviceName");
             if (serviceName != u"GunService"_qs)
             {
                 QJsonIO::SetValue(stream, serviceName, { u"grpcSettings"_qs, u"serviceName"_qs });
@@ -442,25 +540,25 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVLESS(const Q
     }
 
     // tls-wise settings
-    const auto hasSecurity = query.hasQueryItem(u"security"_qs);
-    const auto security = hasSecurity ? query.queryItemValue(u"security"_qs) : u"none"_qs;
+    const auto hasSecurity = url->HasQueryItem("security");
+    const auto security = hasSecurity ? url->QueryItemValue("security") : u"none"_qs;
     const auto tlsKey = security == u"xtls"_qs ? u"xtlsSettings"_qs : u"tlsSettings"_qs;
     if (security != u"none"_qs)
     {
         QJsonIO::SetValue(stream, security, u"security"_qs);
     }
     // sni
-    const auto hasSNI = query.hasQueryItem(u"sni"_qs);
+    const auto hasSNI = url->HasQueryItem("sni");
     if (hasSNI)
     {
-        const auto sni = query.queryItemValue(u"sni"_qs);
+        const auto sni = url->QueryItemValue("sni");
         QJsonIO::SetValue(stream, sni, { tlsKey, u"serverName"_qs });
     }
     // alpn
-    const auto hasALPN = query.hasQueryItem(u"alpn"_qs);
+    const auto hasALPN = url->HasQueryItem("alpn");
     if (hasALPN)
     {
-        const auto alpnRaw = QUrl::fromPercentEncoding(query.queryItemValue(u"alpn"_qs).toUtf8());
+        const auto alpnRaw = url->QueryItemValue("alpn");
         const auto alpnArray = QJsonArray::fromStringList(alpnRaw.split(','));
         QJsonIO::SetValue(stream, alpnArray, { tlsKey, u"alpn"_qs });
     }
@@ -491,7 +589,7 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeOldVMess(cons
         return std::nullopt;
     }
 
-    auto vmessConf = QJsonDocument::fromJson(SafeBase64Decode(b64Str).toUtf8()).object();
+    auto vmessConf = QJsonDocument::fromJson(Qv2ray::Base64::Decode(b64Str.toUtf8())).object();
 
     if (vmessConf.isEmpty())
     {
@@ -671,13 +769,13 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVMess(const Q
 {
     IOConnectionSettings conn;
     conn.protocol = u"vmess"_qs;
-    QUrl url{ link };
-    QUrlQuery query{ url };
-    if (!url.isValid())
+    const auto utf8 = link.toUtf8();
+    const auto url = ShareLink::Parse(utf8);
+    if (!url)
         return std::nullopt;
 
     // If previous alias is empty, just the PS is needed, else, append a "_"
-    const auto name = url.fragment(QUrl::FullyDecoded).trimmed();
+    const auto name = url->Fragment().trimmed();
 
     VMessClientObject client;
 
@@ -686,7 +784,7 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVMess(const Q
     bool tls = false;
     // Check streamSettings
     {
-        for (const auto &_protocol : url.userName().split('+'))
+        for (const auto &_protocol : url->UserName().split('+'))
         {
             if (_protocol == u"tls"_qs)
                 tls = true;
@@ -704,11 +802,11 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVMess(const Q
     }
     // Host Port UUID AlterID
     {
-        const auto host = url.host();
-        int port = url.port();
+        const auto host = url->Host();
+        int port = url->port;
         QString uuid;
         {
-            const auto pswd = url.password();
+            const auto pswd = url->Password();
             const auto index = pswd.lastIndexOf('-');
             uuid = pswd.mid(0, index);
         }
@@ -719,13 +817,7 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeVMess(const Q
         client.security = u"auto"_qs;
     }
 
-    const static auto getQueryValue = [&query](const QString &key, const QString &defaultValue)
-    {
-        if (query.hasQueryItem(key))
-            return query.queryItemValue(key, QUrl::FullyDecoded);
-        else
-            return defaultValue;
-    };
+    const auto getQueryValue = [&url](const QString &key, const QString &defaultValue) { return url->QueryItemValue(key.toUtf8(), defaultValue); };
 
     //
     // Begin transport settings parser
@@ -774,24 +866,21 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeSS(const QStr
     ShadowSocksClientObject server;
     QString d_name;
 
-    auto uri = link.mid(5);
-    auto hashPos = uri.lastIndexOf('#');
-    //    DEBUG("Hash sign position: " + QSTRN(hashPos));
-
-    if (hashPos >= 0)
+    // The base64 parts are decoded straight from the bytes of the link.
+    const auto utf8 = link.toUtf8();
+    auto uri = QByteArrayView(utf8).sliced(5);
+    if (const auto hash = std::find(uri.rbegin(), uri.rend(), '#'); hash != uri.rend())
     {
         // Get the name/remark
-        d_name = uri.mid(uri.lastIndexOf('#') + 1);
-        uri.truncate(hashPos);
+        const auto hashPos = uri.rend() - hash - 1;
+        d_name = ShareLink::Decode(uri.sliced(hashPos + 1));
+        uri = uri.first(hashPos);
     }
 
-    auto atPos = uri.indexOf('@');
-    //    DEBUG("At sign position: " + QSTRN(atPos));
-
-    if (atPos < 0)
+    if (std::find(uri.begin(), uri.end(), '@') == uri.end())
     {
         // Old URI scheme
-        QString decoded = QByteArray::fromBase64(uri.toUtf8(), QByteArray::Base64Option::OmitTrailingEquals);
+        auto decoded = QString::fromUtf8(Qv2ray::Base64::Decode(uri));
         auto colonPos = decoded.indexOf(':');
 
         if (colonPos < 0)
@@ -802,7 +891,7 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeSS(const QStr
 
         server.method = decoded.left(colonPos);
         decoded.remove(0, colonPos + 1);
-        atPos = decoded.lastIndexOf('@');
+        const auto atPos = decoded.lastIndexOf('@');
         //        DEBUG("At sign position: " + QSTRN(atPos));
 
         if (atPos < 0)
@@ -827,10 +916,13 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeSS(const QStr
     else
     {
         // SIP002 URI scheme
-        auto x = QUrl::fromUserInput(uri);
-        conn.address = x.host();
-        conn.port = x.port();
-        const auto userInfo = SafeBase64Decode(x.userName());
+        const auto url = ShareLink::Parse(utf8);
+        if (!url)
+            return std::nullopt;
+        conn.address = url->Host();
+        conn.port = url->port;
+        const auto userName = url->userInfo.first(std::find(url->userInfo.begin(), url->userInfo.end(), ':') - url->userInfo.begin());
+        const auto userInfo = QString::fromUtf8(Qv2ray::Base64::Decode(ShareLink::DecodeBytes(userName)));
         const auto userInfoSp = userInfo.indexOf(':');
         //
         //        DEBUG("Userinfo splitter position: " + QSTRN(userInfoSp));
@@ -845,7 +937,6 @@ std::optional<std::pair<QString, IOConnectionSettings>> DeserializeSS(const QStr
         server.password = userInfo.mid(userInfoSp + 1);
     }
 
-    d_name = QUrl::fromPercentEncoding(d_name.toUtf8());
     conn.protocol = u"shadowsocks"_qs;
     conn.protocolSettings = IOProtocolSettings{ server.toJson() };
     return std::make_pair(d_name, conn);
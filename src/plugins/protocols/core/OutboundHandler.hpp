@@ -2,6 +2,24 @@
 
 #include "QvPlugin/Handlers/OutboundHandler.hpp"
 
+struct DeserializedLink
+{
+    QString name;
+    IOConnectionSettings outbound;
+    // Set when the link cannot be decoded.
+    std::optional<QString> error;
+};
+
+struct SerializedLinks
+{
+    // The links, one per line.
+    QByteArray links;
+    // The same lines as a base64 subscription body, ready to be published.
+    QByteArray subscription;
+    // Names of the connections which have no share link.
+    QStringList skipped;
+};
+
 class BuiltinSerializer : public Qv2rayPlugin::Outbound::IOutboundProcessor
 {
   public:
@@ -9,6 +27,10 @@ class BuiltinSerializer : public Qv2rayPlugin::Outbound::IOutboundProcessor
 
     virtual std::optional<QString> Serialize(const QString &name, const IOConnectionSettings &outbound) const override;
     virtual std::optional<std::pair<QString, IOConnectionSettings>> Deserialize(const QString &link) const override;
+    // Decodes the links in chunks on the global thread pool, the results are in the order of the input.
+    QList<DeserializedLink> DeserializeBatch(const QStringList &links) const;
+    // Writes the links of all connections into a single buffer, which is base64-encoded along the way.
+    SerializedLinks SerializeBatch(const QList<std::pair<QString, IOConnectionSettings>> &connections) const;
 
     virtual std::optional<PluginIOBoundData> GetOutboundInfo(const IOConnectionSettings &) const override;
     virtual bool SetOutboundInfo(IOConnectionSettings &, const PluginIOBoundData &) const override;
@@ -0,0 +1,348 @@
+#include "ShareLink.hpp"
+
+#include <QUrl>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <string_view>
+
+static qsizetype Find(QByteArrayView view, char ch, qsizetype from = 0)
+{
+    const auto it = std::find(view.begin() + from, view.end(), ch);
+    return it == view.end() ? -1 : it - view.begin();
+}
+
+static int HexValue(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+std::optional<ShareLink> ShareLink::Parse(QByteArrayView link)
+{
+    ShareLink result;
+
+    const auto schemeEnd = Find(link, ':');
+    if (schemeEnd <= 0 || !link.sliced(schemeEnd).startsWith("://"))
+        return std::nullopt;
+    result.scheme = link.first(schemeEnd);
+    if (!std::all_of(result.scheme.begin(), result.scheme.end(), [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '+' || ch == '-' || ch == '.'; }))
+        return std::nullopt;
+
+    auto rest = link.sliced(schemeEnd + 3);
+    if (const auto hash = Find(rest, '#'); hash >= 0)
+    {
+        result.fragment = rest.sliced(hash + 1);
+        rest = rest.first(hash);
+    }
+    if (const auto question = Find(rest, '?'); question >= 0)
+    {
+        result.query = rest.sliced(question + 1);
+        rest = rest.first(question);
+    }
+    auto authorityEnd = Find(rest, '/');
+    if (authorityEnd < 0)
+        authorityEnd = rest.size();
+    result.path = rest.sliced(authorityEnd);
+    auto authority = rest.first(authorityEnd);
+
+    // The userinfo may contain unescaped '@' itself, the last one starts the host.
+    if (const auto at = std::find(authority.rbegin(), authority.rend(), '@'); at != authority.rend())
+    {
+        const auto pos = authority.rend() - at - 1;
+        result.userInfo = authority.first(pos);
+        authority = authority.sliced(pos + 1);
+    }
+
+    QByteArrayView portStr;
+    if (authority.startsWith('['))
+    {
+        const auto close = Find(authority, ']');
+        if (close < 0)
+            return std::nullopt;
+        result.host = authority.sliced(1, close - 1);
+        const auto tail = authority.sliced(close + 1);
+        if (!tail.isEmpty() && !tail.startsWith(':'))
+            return std::nullopt;
+        portStr = tail.isEmpty() ? tail : tail.sliced(1);
+    }
+    else if (const auto colon = Find(authority, ':'); colon >= 0)
+    {
+        result.host = authority.first(colon);
+        portStr = authority.sliced(colon + 1);
+    }
+    else
+    {
+        result.host = authority;
+    }
+
+    if (std::any_of(result.host.begin(), result.host.end(), [](char ch) { return ch == ' ' || ch == '<' || ch == '>' || ch == '"' || ch == '\\'; }))
+        return std::nullopt;
+
+    if (!portStr.isEmpty())
+    {
+        int port = 0;
+        for (const auto ch : portStr)
+        {
+            if (ch < '0' || ch > '9')
+                return std::nullopt;
+            port = port * 10 + (ch - '0');
+            if (port > 65535)
+                return std::nullopt;
+        }
+        result.port = port;
+    }
+
+    for (qsizetype begin = 0; begin < result.query.size();)
+    {
+        auto end = Find(result.query, '&', begin);
+        if (end < 0)
+            end = result.query.size();
+        const auto item = result.query.sliced(begin, end - begin);
+        begin = end + 1;
+        if (item.isEmpty())
+            continue;
+
+        if (const auto eq = Find(item, '='); eq >= 0)
+            result.queryItems.append({ item.first(eq), item.sliced(eq + 1) });
+        else
+            result.queryItems.append({ item, {} });
+    }
+
+    return result;
+}
+
+QString ShareLink::Decode(QByteArrayView component)
+{
+    if (Find(component, '%') < 0)
+        return QString::fromUtf8(component);
+    return QString::fromUtf8(DecodeBytes(component));
+}
+
+QByteArray ShareLink::DecodeBytes(QByteArrayView component)
+{
+    QByteArray decoded;
+    decoded.reserve(component.size());
+    for (qsizetype i = 0; i < component.size(); i++)
+    {
+        // Malformed escapes are kept as they are.
+        if (component[i] == '%' && i + 2 < component.size() && HexValue(component[i + 1]) >= 0 && HexValue(component[i + 2]) >= 0)
+        {
+            decoded.append(char(HexValue(component[i + 1]) << 4 | HexValue(component[i + 2])));
+            i += 2;
+        }
+        else
+        {
+            decoded.append(component[i]);
+        }
+    }
+    return decoded;
+}
+
+QString ShareLink::UserInfo() const
+{
+    return Decode(userInfo);
+}
+
+QString ShareLink::UserName() const
+{
+    const auto colon = Find(userInfo, ':');
+    return Decode(colon < 0 ? userInfo : userInfo.first(colon));
+}
+
+QString ShareLink::Password() const
+{
+    const auto colon = Find(userInfo, ':');
+    return colon < 0 ? QString{} : Decode(userInfo.sliced(colon + 1));
+}
+
+// Whether QUrl leaves the host as it is once lowered: letters, digits, hyphens and dots, no empty or ACE labels, and a
+// last label which starts with a letter so that it cannot be read as an IPv4 address.
+static bool IsPlainHostName(QStringView host)
+{
+    QStringView label;
+    for (qsizetype i = 0, labelStart = 0; i <= host.size(); i++)
+    {
+        if (i < host.size() && host[i] != u'.')
+        {
+            const auto ch = host[i].unicode();
+            if (!(ch >= 'a' && ch <= 'z') && !(ch >= '0' && ch <= '9') && ch != '-')
+                return false;
+            continue;
+        }
+        label = host.sliced(labelStart, i - labelStart);
+        if (label.isEmpty() || label.startsWith(u"xn--"))
+            return false;
+        labelStart = i + 1;
+    }
+    return label.front() >= u'a' && label.front() <= u'z';
+}
+
+QString ShareLink::Host() const
+{
+    // Host names are case insensitive, QUrl normalises them to lower case as well.
+    const auto decoded = Decode(host).toLower();
+    if (IsPlainHostName(decoded))
+        return decoded;
+
+    // Internationalised names, IP addresses and anything unusual are normalised by QUrl itself: through the ACE form, so
+    // that the Unicode and the ASCII spelling of a name give the same host, which is shown in Unicode where Qt allows it.
+    QUrl url;
+    url.setHost(decoded);
+    return url.host();
+}
+
+QString ShareLink::Fragment() const
+{
+    return Decode(fragment);
+}
+
+bool ShareLink::HasQueryItem(QByteArrayView key) const
+{
+    return std::any_of(queryItems.cbegin(), queryItems.cend(), [key](const auto &item) { return item.first == key; });
+}
+
+QString ShareLink::QueryItemValue(QByteArrayView key, const QString &defaultValue) const
+{
+    const auto it = std::find_if(queryItems.cbegin(), queryItems.cend(), [key](const auto &item) { return item.first == key; });
+    return it == queryItems.cend() ? defaultValue : Decode(it->second);
+}
+
+// The ASCII characters which are written as they are, everything else is percent-encoded.
+using CharacterSet = std::array<bool, 128>;
+
+static constexpr CharacterSet MakeCharacterSet(std::string_view extra)
+{
+    CharacterSet set{};
+    for (auto c = 'A'; c <= 'Z'; c++)
+        set[size_t(c)] = true;
+    for (auto c = 'a'; c <= 'z'; c++)
+        set[size_t(c)] = true;
+    for (auto c = '0'; c <= '9'; c++)
+        set[size_t(c)] = true;
+    for (const auto c : std::string_view("-._~"))
+        set[size_t(c)] = true;
+    for (const auto c : extra)
+        set[size_t(c)] = true;
+    return set;
+}
+
+constexpr auto UserInfoCharacters = MakeCharacterSet("!$&'()*+,;=");
+// The separators of query items, and '+' which form decoders read as a space, are always encoded.
+constexpr auto QueryCharacters = MakeCharacterSet("!$'()*,/:@");
+constexpr auto FragmentCharacters = MakeCharacterSet("!$&'()*+,;=/:@?");
+
+static void AppendEscaped(QByteArray &out, quint8 byte)
+{
+    constexpr char hex[] = "0123456789ABCDEF";
+    const char escaped[]{ '%', hex[byte >> 4], hex[byte & 0xF] };
+    out.append(escaped, 3);
+}
+
+// Encodes UTF-16 to percent-encoded UTF-8 in one pass, without an intermediate UTF-8 copy.
+static void AppendEncoded(QByteArray &out, QStringView text, const CharacterSet &allowed)
+{
+    for (qsizetype i = 0; i < text.size(); i++)
+    {
+        char32_t codePoint = text[i].unicode();
+        if (codePoint < 0x80)
+        {
+            if (allowed[codePoint])
+                out.append(char(codePoint));
+            else
+                AppendEscaped(out, quint8(codePoint));
+            continue;
+        }
+
+        if (QChar::isHighSurrogate(codePoint) && i + 1 < text.size() && text[i + 1].isLowSurrogate())
+            codePoint = QChar::surrogateToUcs4(char16_t(codePoint), text[++i].unicode());
+        else if (QChar::isSurrogate(codePoint))
+            codePoint = 0xFFFD;
+
+        if (codePoint < 0x800)
+        {
+            AppendEscaped(out, quint8(0xC0 | codePoint >> 6));
+        }
+        else if (codePoint < 0x10000)
+        {
+            AppendEscaped(out, quint8(0xE0 | codePoint >> 12));
+            AppendEscaped(out, quint8(0x80 | (codePoint >> 6 & 0x3F)));
+        }
+        else
+        {
+            AppendEscaped(out, quint8(0xF0 | codePoint >> 18));
+            AppendEscaped(out, quint8(0x80 | (codePoint >> 12 & 0x3F)));
+            AppendEscaped(out, quint8(0x80 | (codePoint >> 6 & 0x3F)));
+        }
+        AppendEscaped(out, quint8(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+void ShareLinkWriter::Begin(QByteArrayView scheme)
+{
+    hasQuery = false;
+    buffer.append(scheme.data(), scheme.size());
+    buffer.append("://", 3);
+}
+
+void ShareLinkWriter::UserInfo(const QString &userName, const QString &password)
+{
+    AppendEncoded(buffer, userName, UserInfoCharacters);
+    if (!password.isEmpty())
+    {
+        buffer.append(':');
+        AppendEncoded(buffer, password, UserInfoCharacters);
+    }
+    buffer.append('@');
+}
+
+void ShareLinkWriter::HostPort(const QString &host, int port)
+{
+    if (host.contains(u':'))
+    {
+        // IPv6 addresses are written in brackets, they need no encoding.
+        buffer.append('[');
+        buffer.append(host.toLatin1());
+        buffer.append(']');
+    }
+    else if (std::all_of(host.cbegin(), host.cend(), [](QChar ch) { return ch.unicode() < 0x80; }))
+    {
+        AppendEncoded(buffer, host.toLower(), UserInfoCharacters);
+    }
+    else
+    {
+        // Internationalised domain names are written in their ASCII form, as QUrl does.
+        buffer.append(QUrl::toAce(host));
+    }
+
+    if (port > 0)
+    {
+        buffer.append(':');
+        buffer.append(QByteArray::number(port));
+    }
+}
+
+void ShareLinkWriter::Path(QByteArrayView path)
+{
+    buffer.append(path.data(), path.size());
+}
+
+void ShareLinkWriter::QueryItem(QByteArrayView key, const QString &value)
+{
+    buffer.append(hasQuery ? '&' : '?');
+    hasQuery = true;
+    buffer.append(key.data(), key.size());
+    buffer.append('=');
+    AppendEncoded(buffer, value, QueryCharacters);
+}
+
+void ShareLinkWriter::Fragment(const QString &fragment)
+{
+    buffer.append('#');
+    AppendEncoded(buffer, fragment, FragmentCharacters);
+}
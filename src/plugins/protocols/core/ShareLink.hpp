@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+#include <optional>
+
+// A share link split into its components in a single pass, without allocating for links with up to 16 query items.
+// The views point into the UTF-8 buffer the link was parsed from, which must outlive the ShareLink.
+// Components are only percent-decoded, fully, when they are asked for.
+class ShareLink
+{
+  public:
+    static std::optional<ShareLink> Parse(QByteArrayView link);
+    static QString Decode(QByteArrayView component);
+    // Percent-decodes a component which is not text, such as base64.
+    static QByteArray DecodeBytes(QByteArrayView component);
+
+    QString UserInfo() const;
+    QString UserName() const;
+    QString Password() const;
+    QString Host() const;
+    QString Fragment() const;
+    bool HasQueryItem(QByteArrayView key) const;
+    QString QueryItemValue(QByteArrayView key, const QString &defaultValue = {}) const;
+
+  public:
+    QByteArrayView scheme;
+    QByteArrayView userInfo;
+    QByteArrayView host;
+    // -1 when the link has no port.
+    int port = -1;
+    QByteArrayView path;
+    QByteArrayView query;
+    QByteArrayView fragment;
+
+  private:
+    QVarLengthArray<std::pair<QByteArrayView, QByteArrayView>, 16> queryItems;
+};
+
+// Writes share links straight into a UTF-8 buffer, percent-encoding every component as it is appended. Any number of
+// links may be written into the same buffer one after another, each one starting with Begin.
+class ShareLinkWriter
+{
+  public:
+    explicit ShareLinkWriter(QByteArray &buffer) : buffer(buffer){};
+
+    void Begin(QByteArrayView scheme);
+    // The password, and its separator, are only written when it is not empty.
+    void UserInfo(const QString &userName, const QString &password = {});
+    void HostPort(const QString &host, int port);
+    void Path(QByteArrayView path);
+    void QueryItem(QByteArrayView key, const QString &value);
+    void Fragment(const QString &fragment);
+
+  private:
+    QByteArray &buffer;
+    bool hasQuery = false;
+};
@@ -0,0 +1,156 @@
+#include "AllocationCounter.hpp"
+#include "core/SubscriptionAdapter.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+
+static QString Uuid(int i)
+{
+    return u"%1-0000-4000-a000-000000000000"_qs.arg(i, 8, 16, QChar(u'0'));
+}
+
+// The proxies cycle through shadowsocks, VMess over WebSocket and TLS, trojan over gRPC and VLESS over TLS, in block
+// and flow style. Proxy groups and rules follow, as in the feeds of the providers, and must be skipped.
+static QByteArray GenerateClashFeed(int proxies)
+{
+    QString feed = u"port: 7890\nmode: rule\nproxies:\n"_qs;
+    for (auto i = 0; i < proxies; i++)
+    {
+        const auto server = u"node-%1.example.com"_qs.arg(i);
+        switch (i % 4)
+        {
+            case 0:
+                feed += u"  - name: \"ss-%1\"\n    type: ss\n    server: %2\n    port: 8388\n    cipher: aes-128-gcm\n    password: \"p@ss:%1\"\n"_qs //
+                            .arg(i)
+                            .arg(server);
+                break;
+            case 1:
+                feed += u"  - name: vmess-%1\n    type: vmess\n    server: %2\n    port: 443\n    uuid: %3\n    alterId: 0\n    cipher: auto\n"
+                        u"    tls: true\n    servername: %2\n    network: ws\n    ws-opts:\n      path: /ws/%1\n      headers:\n        Host: %2\n"_qs //
+                            .arg(i)
+                            .arg(server, Uuid(i));
+                break;
+            case 2:
+                feed += u"  - { name: 'trojan-%1', type: trojan, server: %2, port: 443, password: secret-%1, sni: %2, network: grpc, "
+                        u"grpc-opts: { grpc-service-name: svc-%1 } }\n"_qs //
+                            .arg(i)
+                            .arg(server);
+                break;
+            default:
+                feed += u"  - name: vless-%1 # VLESS over TLS\n    type: vless\n    server: %2\n    port: 443\n    uuid: %3\n    tls: true\n"
+                        u"    alpn: [h2, \"http/1.1\"]\n"_qs //
+                            .arg(i)
+                            .arg(server, Uuid(i));
+                break;
+        }
+    }
+
+    feed += u"proxy-groups:\n  - name: auto\n    type: url-test\n    proxies: [ss-0, vmess-1, trojan-2, vless-3]\nrules:\n"_qs;
+    for (auto i = 0; i < proxies; i++)
+        feed += u"  - DOMAIN-SUFFIX,site-%1.example,auto\n"_qs.arg(i);
+    feed += u"  - MATCH,DIRECT\n"_qs;
+    return feed.toUtf8();
+}
+
+// The same proxies as the Clash feed, followed by the routing outbounds and the route, which must be skipped.
+static QByteArray GenerateSingBoxFeed(int proxies)
+{
+    QString feed = u"{\"log\":{\"level\":\"warn\"},\"outbounds\":["_qs;
+    for (auto i = 0; i < proxies; i++)
+    {
+        const auto server = u"node-%1.example.com"_qs.arg(i);
+        switch (i % 4)
+        {
+            case 0:
+                feed += u"{\"type\":\"shadowsocks\",\"tag\":\"ss-%1\",\"server\":\"%2\",\"server_port\":8388,\"method\":\"aes-128-gcm\",\"password\":\"p@ss:%1\"},"_qs //
+                            .arg(i)
+                            .arg(server);
+                break;
+            case 1:
+                feed += u"{\"type\":\"vmess\",\"tag\":\"vmess-%1\",\"server\":\"%2\",\"server_port\":443,\"uuid\":\"%3\",\"security\":\"auto\","
+                        u"\"tls\":{\"enabled\":true,\"server_name\":\"%2\"},\"transport\":{\"type\":\"ws\",\"path\":\"/ws/%1\",\"headers\":{\"Host\":\"%2\"}}},"_qs //
+                            .arg(i)
+                            .arg(server, Uuid(i));
+                break;
+            case 2:
+                feed += u"{\"type\":\"trojan\",\"tag\":\"trojan-%1\",\"server\":\"%2\",\"server_port\":443,\"password\":\"secret-%1\","
+                        u"\"tls\":{\"enabled\":true,\"server_name\":\"%2\"},\"transport\":{\"type\":\"grpc\",\"service_name\":\"svc-%1\"}},"_qs //
+                            .arg(i)
+                            .arg(server);
+                break;
+            default:
+                feed += u"{\"type\":\"vless\",\"tag\":\"vless-%1\",\"server\":\"%2\",\"server_port\":443,\"uuid\":\"%3\",\"flow\":\"xtls-rprx-vision\","
+                        u"\"tls\":{\"enabled\":true,\"server_name\":\"%2\",\"alpn\":[\"h2\",\"http/1.1\"]}},"_qs //
+                            .arg(i)
+                            .arg(server, Uuid(i));
+                break;
+        }
+    }
+
+    feed += u"{\"type\":\"selector\",\"tag\":\"proxy\",\"outbounds\":[\"ss-0\",\"vmess-1\"]},{\"type\":\"direct\",\"tag\":\"direct\"}],"
+            u"\"route\":{\"rules\":["_qs;
+    for (auto i = 0; i < proxies; i++)
+        feed += u"{\"domain_suffix\":[\"site-%1.example\"],\"outbound\":\"proxy\"},"_qs.arg(i);
+    feed += u"{\"port\":53,\"outbound\":\"direct\"}]}}"_qs;
+    return feed.toUtf8();
+}
+
+using Decoder = std::function<SubscriptionResult(const QByteArray &, QStringList &)>;
+
+// Decodes the feed once untimed, to check that every proxy is read, then times the decoder. Returns false on a mismatch.
+static bool Run(const QString &format, const QByteArray &feed, int proxies, int iterations, const Decoder &decode)
+{
+    QStringList unsupportedNodes;
+    const auto decoded = decode(feed, unsupportedNodes).GetValue<SR_OutboundObjects>().size();
+    if (decoded != proxies || !unsupportedNodes.isEmpty())
+    {
+        QTextStream(stderr) << format << ": " << decoded << " of " << proxies << " proxies decoded, unsupported: " << unsupportedNodes.join(u", "_qs)
+                            << Qt::endl;
+        return false;
+    }
+
+    QList<qint64> times;
+    times.reserve(iterations);
+    const auto allocationsBefore = AllocationCount();
+    for (auto i = 0; i < iterations; i++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        decode(feed, unsupportedNodes);
+        times << timer.nsecsElapsed();
+    }
+    const auto allocations = (AllocationCount() - allocationsBefore) / iterations;
+    std::sort(times.begin(), times.end());
+
+    const auto median = std::max<qint64>(times[times.size() / 2], 1);
+    QTextStream(stdout) << format << ", " << proxies << " proxies, " << feed.size() << " bytes: median " << median / 1e6 << " ms ("
+                        << feed.size() * 1e3 / median << " MB/s, " << qint64(proxies * 1e9 / median) << " proxies/s), min " << times.first() / 1e6
+                        << " ms, " << allocations << " operator new allocations per decode (Qt container storage is allocated with malloc and not counted)."
+                        << Qt::endl;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Times the Clash and sing-box subscription decoders on synthetic feeds."_qs);
+    parser.addHelpOption();
+
+    const QCommandLineOption proxiesOption(u"proxies"_qs, u"Number of proxies in each feed."_qs, u"count"_qs, u"5000"_qs);
+    const QCommandLineOption iterationsOption(u"iterations"_qs, u"Number of timed decodes."_qs, u"count"_qs, u"10"_qs);
+    parser.addOptions({ proxiesOption, iterationsOption });
+    parser.process(app);
+
+    const auto proxies = std::max(parser.value(proxiesOption).toInt(), 1);
+    const auto iterations = std::max(parser.value(iterationsOption).toInt(), 1);
+
+    // The decoders are called without the payload cache, which would answer every decode after the first.
+    auto passed = Run(u"clash"_qs, GenerateClashFeed(proxies), proxies, iterations, &ClashDecoder::Decode);
+    passed &= Run(u"sing-box"_qs, GenerateSingBoxFeed(proxies), proxies, iterations, &SingBoxDecoder::Decode);
+    return passed ? 0 : 1;
+}
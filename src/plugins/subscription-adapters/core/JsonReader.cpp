@@ -0,0 +1,368 @@
+#include "JsonReader.hpp"
+
+// Deeper documents are rejected rather than recursed into.
+constexpr auto JSON_READER_MAX_DEPTH = 256;
+
+static int HexValue(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+static void AppendUtf8(QByteArray &out, char32_t codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        out.append(char(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+        out.append(char(0xC0 | codePoint >> 6));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out.append(char(0xE0 | codePoint >> 12));
+        out.append(char(0x80 | (codePoint >> 6 & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        out.append(char(0xF0 | codePoint >> 18));
+        out.append(char(0x80 | (codePoint >> 12 & 0x3F)));
+        out.append(char(0x80 | (codePoint >> 6 & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+void JsonReader::Fail()
+{
+    error = true;
+    pos = data.size();
+    firstItem.clear();
+}
+
+void JsonReader::SkipWhitespace()
+{
+    while (pos < data.size() && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t'))
+        pos++;
+}
+
+JsonReader::ValueType JsonReader::Peek()
+{
+    SkipWhitespace();
+    if (pos >= data.size())
+        return VALUE_INVALID;
+
+    switch (data[pos])
+    {
+        case '{': return VALUE_OBJECT;
+        case '[': return VALUE_ARRAY;
+        case '"': return VALUE_STRING;
+        case 't':
+        case 'f': return VALUE_BOOL;
+        case 'n': return VALUE_NULL;
+        case '-': return VALUE_NUMBER;
+        default: return data[pos] >= '0' && data[pos] <= '9' ? VALUE_NUMBER : VALUE_INVALID;
+    }
+}
+
+bool JsonReader::EnterObject()
+{
+    if (Peek() != VALUE_OBJECT)
+        return false;
+    if (firstItem.size() >= JSON_READER_MAX_DEPTH)
+    {
+        Fail();
+        return false;
+    }
+    pos++;
+    firstItem.append(true);
+    return true;
+}
+
+bool JsonReader::EnterArray()
+{
+    if (Peek() != VALUE_ARRAY)
+        return false;
+    if (firstItem.size() >= JSON_READER_MAX_DEPTH)
+    {
+        Fail();
+        return false;
+    }
+    pos++;
+    firstItem.append(true);
+    return true;
+}
+
+bool JsonReader::NextItem(char close)
+{
+    SkipWhitespace();
+    if (firstItem.isEmpty() || pos >= data.size())
+    {
+        Fail();
+        return false;
+    }
+
+    if (data[pos] == close)
+    {
+        pos++;
+        firstItem.removeLast();
+        return false;
+    }
+
+    if (!firstItem.last())
+    {
+        if (data[pos] != ',')
+        {
+            Fail();
+            return false;
+        }
+        pos++;
+    }
+    firstItem.last() = false;
+    return true;
+}
+
+bool JsonReader::NextKey(QByteArrayView &key)
+{
+    if (!NextItem('}'))
+        return false;
+
+    SkipWhitespace();
+    if (!ReadRawString(key))
+    {
+        Fail();
+        return false;
+    }
+
+    SkipWhitespace();
+    if (pos >= data.size() || data[pos] != ':')
+    {
+        Fail();
+        return false;
+    }
+    pos++;
+    return true;
+}
+
+bool JsonReader::NextElement()
+{
+    return NextItem(']');
+}
+
+bool JsonReader::ReadRawString(QByteArrayView &out)
+{
+    if (pos >= data.size() || data[pos] != '"')
+        return false;
+
+    // Strings without escapes, which are almost all of them, are returned as views into the document.
+    const auto begin = ++pos;
+    while (pos < data.size() && data[pos] != '"' && data[pos] != '\\')
+        pos++;
+    if (pos >= data.size())
+        return false;
+    if (data[pos] == '"')
+    {
+        out = data.sliced(begin, pos++ - begin);
+        return true;
+    }
+
+    scratch.clear();
+    scratch.append(data.data() + begin, pos - begin);
+
+    const auto readCodeUnit = [this]() -> int
+    {
+        if (pos + 4 > data.size())
+            return -1;
+        auto value = 0;
+        for (auto i = 0; i < 4; i++)
+        {
+            const auto digit = HexValue(data[pos + i]);
+            if (digit < 0)
+                return -1;
+            value = value << 4 | digit;
+        }
+        pos += 4;
+        return value;
+    };
+
+    while (pos < data.size())
+    {
+        const auto ch = data[pos++];
+        if (ch == '"')
+        {
+            out = scratch;
+            return true;
+        }
+        if (ch != '\\')
+        {
+            scratch.append(ch);
+            continue;
+        }
+        if (pos >= data.size())
+            return false;
+
+        switch (const auto escaped = data[pos++]; escaped)
+        {
+            case '"':
+            case '\\':
+            case '/': scratch.append(escaped); break;
+            case 'b': scratch.append('\b'); break;
+            case 'f': scratch.append('\f'); break;
+            case 'n': scratch.append('\n'); break;
+            case 'r': scratch.append('\r'); break;
+            case 't': scratch.append('\t'); break;
+            case 'u':
+            {
+                auto codePoint = readCodeUnit();
+                if (codePoint < 0)
+                    return false;
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && data.sliced(pos).startsWith("\\u"))
+                {
+                    pos += 2;
+                    const auto low = readCodeUnit();
+                    if (low < 0)
+                        return false;
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else
+                    {
+                        AppendUtf8(scratch, 0xFFFD);
+                        codePoint = low;
+                    }
+                }
+                // Unpaired surrogates cannot be represented in UTF-8.
+                if (codePoint >= 0xD800 && codePoint < 0xE000)
+                    codePoint = 0xFFFD;
+                AppendUtf8(scratch, char32_t(codePoint));
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+QByteArrayView JsonReader::ReadLiteral()
+{
+    const auto begin = pos;
+    while (pos < data.size() && data[pos] != ',' && data[pos] != '}' && data[pos] != ']' && data[pos] != ' ' && data[pos] != '\n' && data[pos] != '\r' &&
+           data[pos] != '\t')
+        pos++;
+    return data.sliced(begin, pos - begin);
+}
+
+QString JsonReader::ReadString()
+{
+    if (Peek() != VALUE_STRING)
+    {
+        Skip();
+        return {};
+    }
+
+    QByteArrayView value;
+    if (!ReadRawString(value))
+    {
+        Fail();
+        return {};
+    }
+    return QString::fromUtf8(value);
+}
+
+double JsonReader::ReadNumber()
+{
+    switch (Peek())
+    {
+        case VALUE_NUMBER:
+        {
+            const auto literal = ReadLiteral();
+            bool ok = false;
+            const auto value = QByteArray::fromRawData(literal.data(), literal.size()).toDouble(&ok);
+            if (!ok)
+                Fail();
+            return value;
+        }
+        // Some providers quote their numbers.
+        case VALUE_STRING: return ReadString().toDouble();
+        default: Skip(); return 0;
+    }
+}
+
+int JsonReader::ReadInt()
+{
+    return static_cast<int>(ReadNumber());
+}
+
+bool JsonReader::ReadBool()
+{
+    if (Peek() != VALUE_BOOL)
+    {
+        Skip();
+        return false;
+    }
+
+    const auto literal = ReadLiteral();
+    if (literal != "true" && literal != "false")
+        Fail();
+    return literal == "true";
+}
+
+QStringList JsonReader::ReadStringList()
+{
+    QStringList list;
+    if (!EnterArray())
+    {
+        Skip();
+        return list;
+    }
+
+    while (NextElement())
+        list << ReadString();
+    return list;
+}
+
+void JsonReader::Skip()
+{
+    switch (Peek())
+    {
+        case VALUE_OBJECT:
+        {
+            EnterObject();
+            QByteArrayView key;
+            while (NextKey(key))
+                Skip();
+            break;
+        }
+        case VALUE_ARRAY:
+        {
+            EnterArray();
+            while (NextElement())
+                Skip();
+            break;
+        }
+        case VALUE_STRING:
+        {
+            QByteArrayView value;
+            if (!ReadRawString(value))
+                Fail();
+            break;
+        }
+        case VALUE_NUMBER: ReadLiteral(); break;
+        case VALUE_BOOL: ReadBool(); break;
+        case VALUE_NULL:
+        {
+            if (ReadLiteral() != "null")
+                Fail();
+            break;
+        }
+        case VALUE_INVALID: Fail(); break;
+    }
+}
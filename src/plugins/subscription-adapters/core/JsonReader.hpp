@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+
+// A pull parser over a JSON document: values are read, or skipped, in document order straight into the caller's
+// types, no document tree is ever built. Malformed input stops the reader, every further read returns nothing.
+class JsonReader
+{
+  public:
+    enum ValueType
+    {
+        VALUE_INVALID,
+        VALUE_NULL,
+        VALUE_BOOL,
+        VALUE_NUMBER,
+        VALUE_STRING,
+        VALUE_ARRAY,
+        VALUE_OBJECT,
+    };
+
+    explicit JsonReader(QByteArrayView data) : data(data){};
+
+    ValueType Peek();
+    // Returns false, consuming nothing, if the next value is not an object.
+    bool EnterObject();
+    // Returns false after the last member of the object. The key is only valid until the next read.
+    bool NextKey(QByteArrayView &key);
+    // Returns false, consuming nothing, if the next value is not an array.
+    bool EnterArray();
+    // Returns false after the last element of the array.
+    bool NextElement();
+
+    // Values of another type are skipped and read as empty.
+    QString ReadString();
+    double ReadNumber();
+    int ReadInt();
+    bool ReadBool();
+    QStringList ReadStringList();
+    void Skip();
+
+    bool HasError() const
+    {
+        return error;
+    }
+
+  private:
+    void SkipWhitespace();
+    bool NextItem(char close);
+    bool ReadRawString(QByteArrayView &out);
+    QByteArrayView ReadLiteral();
+    void Fail();
+
+  private:
+    QByteArrayView data;
+    qsizetype pos = 0;
+    bool error = false;
+    // Whether the innermost open container has not had an item read yet.
+    QVarLengthArray<bool, 16> firstItem;
+    // Strings with escapes are decoded into here.
+    QByteArray scratch;
+};
@@ -0,0 +1,153 @@
+#include "PayloadCache.hpp"
+
+#include "BuiltinSubscriptionAdapter.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+// Written on the first line of every entry. It must change whenever a decoder produces a different result for the same
+// payload, or the format of the entries changes, so that the entries written before are not used.
+constexpr auto PAYLOAD_CACHE_VERSION = "qv2ray-payload-cache/2";
+// The number of payloads kept for each decoder which does not know the source of its payloads.
+constexpr auto PAYLOAD_CACHE_DECODER_ENTRIES = 8;
+
+static QJsonObject ResultToJson(const SubscriptionResult &result)
+{
+    QJsonArray tags;
+    const auto resultTags = result.GetValue<SR_Tags>();
+    for (auto it = resultTags.cbegin(); it != resultTags.cend(); ++it)
+        tags.append(QJsonArray{ it.key(), QJsonArray::fromStringList(it.value()) });
+
+    QJsonArray outbounds;
+    const auto resultOutbounds = result.GetValue<SR_OutboundObjects>();
+    for (auto it = resultOutbounds.cbegin(); it != resultOutbounds.cend(); ++it)
+        outbounds.append(QJsonArray{ it.key(), it.value().toJson() });
+
+    return QJsonObject{
+        { u"links"_qs, QJsonArray::fromStringList(result.GetValue<SR_Links>()) }, //
+        { u"tags"_qs, tags },                                                     //
+        { u"outbounds"_qs, outbounds },
+    };
+}
+
+static SubscriptionResult ResultFromJson(const QJsonObject &json)
+{
+    SubscriptionResult result;
+
+    QStringList links;
+    for (const auto &link : json.value(u"links"_qs).toArray())
+        links << link.toString();
+    if (!links.isEmpty())
+        result.SetValue<SR_Links>(links);
+
+    SubscriptionResult::result_type_t<SR_Tags> tags;
+    for (const auto &entry : json.value(u"tags"_qs).toArray())
+    {
+        const auto pair = entry.toArray();
+        QStringList entryTags;
+        for (const auto &tag : pair.at(1).toArray())
+            entryTags << tag.toString();
+        tags.insert(pair.at(0).toString(), entryTags);
+    }
+    if (!tags.isEmpty())
+        result.SetValue<SR_Tags>(tags);
+
+    SubscriptionResult::result_type_t<SR_OutboundObjects> outbounds;
+    for (const auto &entry : json.value(u"outbounds"_qs).toArray())
+    {
+        const auto pair = entry.toArray();
+        SubscriptionResult::result_type_t<SR_OutboundObjects>::mapped_type outbound;
+        outbound.loadJson(pair.at(1).toObject());
+        outbounds.insert(pair.at(0).toString(), outbound);
+    }
+    if (!outbounds.isEmpty())
+        result.SetValue<SR_OutboundObjects>(outbounds);
+
+    return result;
+}
+
+QString PayloadCache::DecoderDirectory(QByteArrayView decoder)
+{
+    // Decoder names are fixed identifiers, they are safe as directory names.
+    const auto dir = InternalSubscriptionSupportPlugin::PluginInstance->WorkingDirectory().filePath(u"payload-cache/"_qs + QString::fromLatin1(decoder));
+    QDir().mkpath(dir);
+    return dir;
+}
+
+QString PayloadCache::EntryPath(QByteArrayView decoder, const QByteArray &payloadHash, const QUrl &source)
+{
+    if (source.isEmpty())
+        return DecoderDirectory(decoder) + u'/' + QString::fromLatin1(payloadHash) + u".json"_qs;
+
+    const auto dir = InternalSubscriptionSupportPlugin::PluginInstance->WorkingDirectory().filePath(u"payload-cache"_qs);
+    QDir().mkpath(dir);
+
+    // The URL may contain tokens, it is not used as a file name as it is.
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(decoder.data(), decoder.size());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(source.toEncoded());
+    return dir + u'/' + QString::fromLatin1(hash.result().toHex()) + u".json"_qs;
+}
+
+QByteArray PayloadCache::Hash(const QByteArray &payload)
+{
+    return QCryptographicHash::hash(payload, QCryptographicHash::Sha256).toHex();
+}
+
+// An entry is the cache version on its first line and the hash of the payload on its second, followed by the result.
+static std::optional<SubscriptionResult> ReadEntry(const QString &path, const QByteArray &payloadHash)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    // The result is not even read when it was written by another version or belongs to another payload.
+    if (file.readLine().trimmed() != PAYLOAD_CACHE_VERSION)
+        return std::nullopt;
+    if (const auto hash = file.readLine().trimmed(); !payloadHash.isEmpty() && hash != payloadHash)
+        return std::nullopt;
+
+    const auto json = QJsonDocument::fromJson(file.readAll());
+    if (!json.isObject())
+        return std::nullopt;
+    return ResultFromJson(json.object());
+}
+
+std::optional<SubscriptionResult> PayloadCache::Find(QByteArrayView decoder, const QByteArray &payloadHash, const QUrl &source)
+{
+    return ReadEntry(EntryPath(decoder, payloadHash, source), payloadHash);
+}
+
+std::optional<SubscriptionResult> PayloadCache::FindLast(QByteArrayView decoder, const QUrl &source)
+{
+    if (!source.isEmpty())
+        return ReadEntry(EntryPath(decoder, {}, source), {});
+
+    const auto entries = QDir(DecoderDirectory(decoder)).entryInfoList({ u"*.json"_qs }, QDir::Files, QDir::Time);
+    if (entries.isEmpty())
+        return std::nullopt;
+    return ReadEntry(entries.first().filePath(), {});
+}
+
+void PayloadCache::Store(QByteArrayView decoder, const QByteArray &payloadHash, const SubscriptionResult &result, const QUrl &source)
+{
+    QSaveFile file(EntryPath(decoder, payloadHash, source));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(QByteArray(PAYLOAD_CACHE_VERSION) + '\n');
+    file.write(payloadHash + '\n');
+    file.write(QJsonDocument(ResultToJson(result)).toJson(QJsonDocument::Compact));
+    if (!file.commit() || !source.isEmpty())
+        return;
+
+    // Only the most recently stored payloads of the decoder are kept.
+    const auto entries = QDir(DecoderDirectory(decoder)).entryInfoList({ u"*.json"_qs }, QDir::Files, QDir::Time);
+    for (auto i = PAYLOAD_CACHE_DECODER_ENTRIES; i < entries.size(); i++)
+        QFile::remove(entries.at(i).filePath());
+}
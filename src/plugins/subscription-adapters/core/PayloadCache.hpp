@@ -0,0 +1,29 @@
+#pragma once
+
+#include "QvPlugin/PluginInterface.hpp"
+
+#include <QByteArray>
+#include <QUrl>
+#include <optional>
+
+using namespace Qv2rayPlugin;
+
+// Keeps the decoded result of the last payload of every source and decoder, together with a hash of that payload, so
+// that a payload which has been decoded before, be it a re-fetch returning identical bytes or the first update after a
+// restart, is restored from a single file instead of being decoded again. Storing a result replaces the previous one.
+// Decoders which are only given the payload do not know its source, they keep the results of their last few payloads,
+// so that several subscriptions in the same format do not evict each other.
+class PayloadCache
+{
+  public:
+    static QByteArray Hash(const QByteArray &payload);
+    // The result stored for the source and decoder, if it was decoded from the payload with the hash.
+    static std::optional<SubscriptionResult> Find(QByteArrayView decoder, const QByteArray &payloadHash, const QUrl &source = {});
+    // The result stored for the source and decoder, whatever payload it was decoded from.
+    static std::optional<SubscriptionResult> FindLast(QByteArrayView decoder, const QUrl &source = {});
+    static void Store(QByteArrayView decoder, const QByteArray &payloadHash, const SubscriptionResult &result, const QUrl &source = {});
+
+  private:
+    static QString DecoderDirectory(QByteArrayView decoder);
+    static QString EntryPath(QByteArrayView decoder, const QByteArray &payloadHash, const QUrl &source);
+};
@@ -0,0 +1,139 @@
+#include "StreamingLinkDecoder.hpp"
+
+#include "Base64.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+// Base64 never contains ':', while a plain link has its "://" within the first few characters.
+constexpr auto STREAMING_DECODER_DETECT_LENGTH = 64;
+
+void StreamingLinkDecoder::Feed(QByteArrayView chunk)
+{
+    switch (mode)
+    {
+        case MODE_UNKNOWN: DetectMode(chunk); break;
+        case MODE_PLAIN: FeedLines(chunk); break;
+        case MODE_BASE64: FeedBase64(chunk); break;
+        case MODE_BASE64_DONE: break;
+    }
+}
+
+void StreamingLinkDecoder::Finish()
+{
+    if (mode == MODE_UNKNOWN)
+    {
+        mode = pending.contains(':') ? MODE_PLAIN : MODE_BASE64;
+        const auto buffered = std::exchange(pending, {});
+        Feed(buffered);
+    }
+
+    // A trailing group of 2 or 3 characters, without padding.
+    if (mode == MODE_BASE64 && !pending.isEmpty())
+        FeedLines(Qv2ray::Base64::Decode(std::exchange(pending, {})));
+
+    if (!line.isEmpty())
+        EmitLine(std::exchange(line, {}));
+}
+
+void StreamingLinkDecoder::DetectMode(QByteArrayView chunk)
+{
+    const auto isSignificant = [](char ch) { return !std::isspace(static_cast<unsigned char>(ch)); };
+    const auto hasColon = pending.contains(':') || std::find(chunk.begin(), chunk.end(), ':') != chunk.end();
+    if (hasColon)
+        mode = MODE_PLAIN;
+    else if (std::count_if(pending.cbegin(), pending.cend(), isSignificant) + std::count_if(chunk.begin(), chunk.end(), isSignificant) >= STREAMING_DECODER_DETECT_LENGTH)
+        mode = MODE_BASE64;
+
+    if (mode == MODE_UNKNOWN)
+    {
+        pending.append(chunk.data(), chunk.size());
+        return;
+    }
+
+    const auto buffered = std::exchange(pending, {});
+    Feed(buffered);
+    Feed(chunk);
+}
+
+void StreamingLinkDecoder::FeedBase64(QByteArrayView chunk)
+{
+    using Qv2ray::Base64::BASE64_INVALID;
+    using Qv2ray::Base64::DecodeTable;
+
+    // Only whole groups of four characters are decoded, the group they start with is completed by the carried characters.
+    auto valid = std::count_if(pending.cbegin(), pending.cend(), [](char ch) { return DecodeTable[quint8(ch)] != BASE64_INVALID; });
+    qsizetype firstCut = -1;
+    qsizetype cut = 0;
+    for (qsizetype i = 0; i < chunk.size(); i++)
+    {
+        if (chunk[i] == '=')
+        {
+            // Padding ends the body, the partial group before it is decoded as well.
+            mode = MODE_BASE64_DONE;
+            cut = i;
+            if (firstCut < 0)
+                firstCut = i;
+            break;
+        }
+
+        if (DecodeTable[quint8(chunk[i])] != BASE64_INVALID && ++valid % 4 == 0)
+        {
+            if (firstCut < 0)
+                firstCut = i + 1;
+            cut = i + 1;
+        }
+    }
+
+    if (firstCut < 0)
+    {
+        pending.append(chunk.data(), chunk.size());
+        return;
+    }
+
+    if (!pending.isEmpty())
+    {
+        pending.append(chunk.data(), firstCut);
+        FeedLines(Qv2ray::Base64::Decode(pending));
+    }
+    else
+    {
+        firstCut = 0;
+    }
+    FeedLines(Qv2ray::Base64::Decode(chunk.sliced(firstCut, cut - firstCut)));
+
+    if (mode == MODE_BASE64_DONE)
+        pending.clear();
+    else
+        pending = chunk.sliced(cut).toByteArray();
+}
+
+void StreamingLinkDecoder::FeedLines(QByteArrayView decoded)
+{
+    qsizetype start = 0;
+    for (qsizetype i = 0; i < decoded.size(); i++)
+    {
+        if (decoded[i] != '\r' && decoded[i] != '\n')
+            continue;
+
+        // Lines which are complete within the chunk are never copied.
+        if (line.isEmpty())
+        {
+            EmitLine(decoded.sliced(start, i - start));
+        }
+        else
+        {
+            line.append(decoded.data() + start, i - start);
+            EmitLine(std::exchange(line, {}));
+        }
+        start = i + 1;
+    }
+    line.append(decoded.data() + start, decoded.size() - start);
+}
+
+void StreamingLinkDecoder::EmitLine(QByteArrayView data)
+{
+    if (const auto link = QString::fromUtf8(data).trimmed(); !link.isEmpty())
+        onLink(link);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <functional>
+
+// Decodes a "Base64 Links" subscription body as it arrives, either plain links or one base64 blob of links,
+// and hands out every non-empty line as soon as it is complete. Only an incomplete base64 group and an
+// incomplete line are ever buffered, the body is never held as a whole.
+class StreamingLinkDecoder
+{
+  public:
+    explicit StreamingLinkDecoder(std::function<void(const QString &)> onLink) : onLink(std::move(onLink)){};
+    void Feed(QByteArrayView chunk);
+    // Flushes the trailing base64 group and the last line.
+    void Finish();
+
+  private:
+    void DetectMode(QByteArrayView chunk);
+    void FeedBase64(QByteArrayView chunk);
+    void FeedLines(QByteArrayView decoded);
+    void EmitLine(QByteArrayView data);
+
+  private:
+    enum
+    {
+        MODE_UNKNOWN,
+        MODE_PLAIN,
+        MODE_BASE64,
+        MODE_BASE64_DONE,
+    } mode = MODE_UNKNOWN;
+
+    std::function<void(const QString &)> onLink;
+    // Undecided input, then the base64 characters of an incomplete group.
+    QByteArray pending;
+    // Decoded bytes after the last line break.
+    QByteArray line;
+};
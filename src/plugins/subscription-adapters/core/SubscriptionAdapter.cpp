@@ -1,25 +1,20 @@
 #include "SubscriptionAdapter.hpp"
 
+#include "Base64.hpp"
 #include "BuiltinSubscriptionAdapter.hpp"
+#include "JsonReader.hpp"
+#include "PayloadCache.hpp"
+#include "StreamingLinkDecoder.hpp"
+#include "V2RayModels.hpp"
+#include "YamlReader.hpp"
 
-#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QSslKey>
 #include <QUrl>
 #include <QUrlQuery>
-
-const inline QStringList SplitLines(const QString &_string)
-{
-    return _string.split(QRegularExpression(u"[\r\n]"_qs), Qt::SkipEmptyParts);
-}
-
-static QString SafeBase64Decode(QString string)
-{
-    QByteArray ba = string.replace(QChar('-'), QChar('+')).replace(QChar('_'), QChar('/')).toUtf8();
-    return QByteArray::fromBase64(ba, QByteArray::Base64Option::OmitTrailingEquals);
-}
+#include <optional>
 
 QString SafeBase64Encode(const QString &string)
 {
@@ -27,68 +22,548 @@ QString SafeBase64Encode(const QString &string)
     return base64.replace(QChar('+'), QChar('-')).replace(QChar('/'), QChar('_'));
 }
 
+constexpr qsizetype SUBSCRIPTION_DECODE_SLICE_SIZE = 64 * 1024;
+
 // Simple Base64 Decoder
 SubscriptionResult SimpleBase64Decoder::DecodeSubscription(const QByteArray &data) const
 {
-    const auto source = QString::fromUtf8(data).trimmed();
-    const auto resultList = source.contains(u"://"_qs) ? source : SafeBase64Decode(source);
+    const auto payloadHash = PayloadCache::Hash(data);
+    if (const auto cached = PayloadCache::Find("simple_base64", payloadHash))
+        return *cached;
+
+    // Fed in slices so that neither the decoded body nor its UTF-16 copy is ever materialised as a whole.
+    QStringList links;
+    StreamingLinkDecoder decoder{ [&links](const QString &link) { links << link; } };
+    for (qsizetype offset = 0; offset < data.size(); offset += SUBSCRIPTION_DECODE_SLICE_SIZE)
+        decoder.Feed(QByteArrayView(data).sliced(offset, std::min<qsizetype>(SUBSCRIPTION_DECODE_SLICE_SIZE, data.size() - offset)));
+    decoder.Finish();
 
     SubscriptionResult result;
-    result.SetValue<SR_Links>(SplitLines(resultList));
+    result.SetValue<SR_Links>(links);
+    PayloadCache::Store("simple_base64", payloadHash, result);
     return result;
 }
 
+// The members of SIP008 and OOCv1 shadowsocks servers, both spellings share a single dispatch table.
+enum ShadowsocksServerField
+{
+    FIELD_UNKNOWN,
+    FIELD_ADDRESS,
+    FIELD_PORT,
+    FIELD_METHOD,
+    FIELD_PASSWORD,
+    FIELD_NAME,
+    FIELD_PLUGIN,
+    FIELD_TAGS,
+};
+
+constexpr std::pair<QByteArrayView, ShadowsocksServerField> ShadowsocksServerFields[]{
+    { "server", FIELD_ADDRESS },    //
+    { "address", FIELD_ADDRESS },   //
+    { "server_port", FIELD_PORT },  //
+    { "port", FIELD_PORT },         //
+    { "method", FIELD_METHOD },     //
+    { "password", FIELD_PASSWORD }, //
+    { "remarks", FIELD_NAME },      //
+    { "name", FIELD_NAME },         //
+    { "plugin", FIELD_PLUGIN },     //
+    { "pluginName", FIELD_PLUGIN }, //
+    { "tags", FIELD_TAGS },
+};
+
+struct ShadowsocksServer
+{
+    QString name;
+    // Present, possibly empty, when the server names a SIP003 plugin.
+    std::optional<QString> plugin;
+    QStringList tags;
+    IOConnectionSettings connectionSettings;
+};
+
+// Reads one server straight into its outbound settings, so that only a single server is held at a time.
+static ShadowsocksServer ReadShadowsocksServer(JsonReader &reader)
+{
+    ShadowsocksServer server;
+    server.connectionSettings.protocol = u"shadowsocks"_qs;
+    if (!reader.EnterObject())
+    {
+        reader.Skip();
+        return server;
+    }
+
+    QString method;
+    QString password;
+    QByteArrayView key;
+    while (reader.NextKey(key))
+    {
+        const auto field = std::find_if(std::begin(ShadowsocksServerFields), std::end(ShadowsocksServerFields), [key](const auto &f) { return f.first == key; });
+        switch (field == std::end(ShadowsocksServerFields) ? FIELD_UNKNOWN : field->second)
+        {
+            case FIELD_ADDRESS: server.connectionSettings.address = reader.ReadString(); break;
+            case FIELD_PORT: server.connectionSettings.port = reader.ReadInt(); break;
+            case FIELD_METHOD: method = reader.ReadString(); break;
+            case FIELD_PASSWORD: password = reader.ReadString(); break;
+            case FIELD_NAME: server.name = reader.ReadString(); break;
+            case FIELD_PLUGIN: server.plugin = reader.ReadString(); break;
+            case FIELD_TAGS: server.tags = reader.ReadStringList(); break;
+            case FIELD_UNKNOWN: reader.Skip(); break;
+        }
+    }
+
+    IOProtocolSettings protocolSettings;
+    protocolSettings.insert(u"method"_qs, method);
+    protocolSettings.insert(u"password"_qs, password);
+    server.connectionSettings.protocolSettings = protocolSettings;
+    return server;
+}
+
+// Calls onElement, positioned on the element, for every element of the array member named arrayKey of the document root,
+// skipping everything else.
+template<typename F>
+static void ReadRootArray(const QByteArray &data, QByteArrayView arrayKey, F &&onElement)
+{
+    JsonReader reader(data);
+    if (!reader.EnterObject())
+        return;
+
+    QByteArrayView key;
+    while (reader.NextKey(key))
+    {
+        if (key != arrayKey || !reader.EnterArray())
+        {
+            reader.Skip();
+            continue;
+        }
+
+        while (reader.NextElement())
+            onElement(reader);
+    }
+
+    if (reader.HasError())
+        qWarning() << "Malformed subscription document, servers up to the error are kept.";
+}
+
+template<typename F>
+static void ReadShadowsocksServers(const QByteArray &data, QByteArrayView arrayKey, F &&onServer)
+{
+    ReadRootArray(data, arrayKey, [&onServer](JsonReader &reader) { onServer(ReadShadowsocksServer(reader)); });
+}
+
+// A proxy of the Clash and sing-box formats, with the protocol and transport in the spelling of V2Ray.
+struct ProxyServer
+{
+    QString name;
+    QString protocol;
+    QString address;
+    int port = 0;
+    // The shadowsocks method, or the VMess security.
+    QString method;
+    QString password;
+    QString username;
+    QString uuid;
+    QString flow;
+    bool hasPlugin = false;
+
+    // Left empty when the transport is not supported.
+    QString network{ u"tcp"_qs };
+    QString path;
+    QStringList host;
+    QString serviceName;
+
+    bool tls = false;
+    QString serverName;
+    QStringList alpn;
+};
+
+static std::optional<IOConnectionSettings> MakeConnectionSettings(const ProxyServer &server)
+{
+    IOConnectionSettings settings;
+    settings.protocol = server.protocol;
+    settings.address = server.address;
+    settings.port = server.port;
+
+    IOProtocolSettings protocolSettings;
+    if (server.protocol == u"shadowsocks"_qs)
+    {
+        // SIP003 plugins not supported.
+        if (server.hasPlugin)
+            return std::nullopt;
+        protocolSettings.insert(u"method"_qs, server.method);
+        protocolSettings.insert(u"password"_qs, server.password);
+    }
+    else if (server.protocol == u"vmess"_qs)
+    {
+        Qv2ray::Models::VMessClientObject client;
+        client.id = server.uuid;
+        if (!server.method.isEmpty())
+            client.security = server.method;
+        protocolSettings = IOProtocolSettings{ client.toJson() };
+    }
+    else if (server.protocol == u"vless"_qs)
+    {
+        Qv2ray::Models::VLESSClientObject client;
+        client.id = server.uuid;
+        protocolSettings = IOProtocolSettings{ client.toJson() };
+        if (!server.flow.isEmpty())
+            protocolSettings.insert(u"flow"_qs, server.flow);
+    }
+    else if (server.protocol == u"trojan"_qs)
+    {
+        protocolSettings.insert(u"password"_qs, server.password);
+    }
+    else if (server.protocol == u"socks"_qs || server.protocol == u"http"_qs)
+    {
+        if (!server.username.isEmpty())
+            protocolSettings.insert(u"user"_qs, server.username);
+        if (!server.password.isEmpty())
+            protocolSettings.insert(u"pass"_qs, server.password);
+    }
+    else
+    {
+        return std::nullopt;
+    }
+    settings.protocolSettings = protocolSettings;
+
+    if (server.network == u"tcp"_qs && !server.tls)
+        return settings;
+
+    Qv2ray::Models::StreamSettingsObject stream;
+    stream.network = server.network;
+    if (server.network == u"ws"_qs)
+    {
+        if (!server.path.isEmpty())
+            stream.wsSettings->path = server.path;
+        if (!server.host.isEmpty())
+            stream.wsSettings->headers->insert(u"Host"_qs, server.host.first());
+    }
+    else if (server.network == u"http"_qs)
+    {
+        stream.httpSettings->host = server.host;
+        if (!server.path.isEmpty())
+            stream.httpSettings->path = server.path;
+    }
+    else if (server.network == u"grpc"_qs)
+    {
+        stream.grpcSettings->serviceName = server.serviceName;
+    }
+    else if (server.network != u"tcp"_qs)
+    {
+        return std::nullopt;
+    }
+
+    if (server.tls)
+    {
+        stream.security = u"tls"_qs;
+        stream.tlsSettings->serverName = server.serverName;
+        stream.tlsSettings->alpn = server.alpn;
+    }
+    settings.streamSettings = IOStreamSettings{ stream.toJson() };
+    return settings;
+}
+
+static void InsertProxyServer(SubscriptionResult::result_type_t<SR_OutboundObjects> &outbounds, QStringList &unsupportedNodes, const ProxyServer &server)
+{
+    const auto settings = MakeConnectionSettings(server);
+    if (!settings)
+    {
+        qWarning() << "Unsupported node:" << server.name;
+        unsupportedNodes << server.name;
+        return;
+    }
+    outbounds.insert(server.name, { *settings });
+}
+
+static void ReportUnsupportedNodes(const QStringList &unsupportedNodes)
+{
+    if (!unsupportedNodes.isEmpty())
+        InternalSubscriptionSupportPlugin::ShowMessageBox(QObject::tr("Subscription contains unsupported nodes"), unsupportedNodes.join('\n'));
+}
+
 // SIP008 Decoder
 SubscriptionResult SIP008Decoder::DecodeSubscription(const QByteArray &data) const
 {
-    const auto root = QJsonDocument::fromJson(data).object();
-    //
-    // const auto version = root["version"].toString();
-    // const auto username = root["username"].toString();
-    // const auto user_uuid = root["user_uuid"].toString();
-    const auto servers = root[u"servers"_qs].toArray();
+    const auto payloadHash = PayloadCache::Hash(data);
+    if (const auto cached = PayloadCache::Find("sip008", payloadHash))
+        return *cached;
 
     // ss://Y2hhY2hhMjAtaWV0Zi1wb2x5MTMwNTpwYXNzQGhvc3Q6MTIzNA/?plugin=plugin%3Bopt#sssip003
 
     SubscriptionResult result;
     SubscriptionResult::result_type_t<SR_Tags> tags;
     SubscriptionResult::result_type_t<SR_OutboundObjects> outbounds;
-    for (const auto &servVal : servers)
-    {
-        const auto serverObj = servVal.toObject();
-#define GetVal(x) const auto x = serverObj[u## #x##_qs].toString()
-        GetVal(server);
-        GetVal(password);
-        GetVal(method);
-        GetVal(plugin);
-        GetVal(remarks);
-        // GetVal(plugin_opts);
-        // GetVal(id);
-#undef GetVal
-
-        // id, group, owner omitted.
-        if (!plugin.isEmpty())
+    QStringList unsupportedNodes;
+    ReadShadowsocksServers(data, "servers",
+                           [&](const ShadowsocksServer &server)
+                           {
+                               // id, group, owner omitted.
+                               if (server.plugin && !server.plugin->isEmpty())
+                               {
+                                   // SIP003 plugins not supported.
+                                   qWarning() << "Unsupported node:" << server.name;
+                                   unsupportedNodes << server.name;
+                                   return;
+                               }
+
+                               tags.insert(server.name, server.tags);
+                               outbounds.insert(server.name, { server.connectionSettings });
+                           });
+    ReportUnsupportedNodes(unsupportedNodes);
+
+    result.SetValue<SR_Tags>(tags);
+    result.SetValue<SR_OutboundObjects>(outbounds);
+    PayloadCache::Store("sip008", payloadHash, result);
+    return result;
+}
+
+static ProxyServer ReadClashProxy(const QVariantMap &proxy)
+{
+    const auto value = [&proxy](const QString &key) { return proxy.value(key).toString(); };
+    const auto isTrue = [](const QVariant &flag) { return flag.toString().compare(u"true"_qs, Qt::CaseInsensitive) == 0; };
+
+    ProxyServer server;
+    server.name = value(u"name"_qs);
+    server.address = value(u"server"_qs);
+    server.port = value(u"port"_qs).toInt();
+    server.method = value(u"cipher"_qs);
+    server.password = value(u"password"_qs);
+    server.username = value(u"username"_qs);
+    server.uuid = value(u"uuid"_qs);
+    server.flow = value(u"flow"_qs);
+    server.hasPlugin = proxy.contains(u"plugin"_qs);
+
+    const auto type = value(u"type"_qs);
+    server.protocol = type == u"ss"_qs ? u"shadowsocks"_qs : type == u"socks5"_qs ? u"socks"_qs : type;
+
+    // Trojan always runs over TLS, it names its server "sni" where the others use "servername".
+    server.tls = type == u"trojan"_qs || isTrue(proxy.value(u"tls"_qs));
+    server.serverName = proxy.contains(u"sni"_qs) ? value(u"sni"_qs) : value(u"servername"_qs);
+    server.alpn = proxy.value(u"alpn"_qs).toStringList();
+
+    // Clash "http" is the HTTP/1.1 header obfuscation of TCP, which is not supported.
+    const auto network = value(u"network"_qs);
+    if (network == u"ws"_qs)
+    {
+        const auto options = proxy.value(u"ws-opts"_qs).toMap();
+        server.network = u"ws"_qs;
+        server.path = options.value(u"path"_qs).toString();
+        if (const auto host = options.value(u"headers"_qs).toMap().value(u"Host"_qs).toString(); !host.isEmpty())
+            server.host << host;
+    }
+    else if (network == u"h2"_qs)
+    {
+        const auto options = proxy.value(u"h2-opts"_qs).toMap();
+        server.network = u"http"_qs;
+        server.path = options.value(u"path"_qs).toString();
+        server.host = options.value(u"host"_qs).toStringList();
+    }
+    else if (network == u"grpc"_qs)
+    {
+        server.network = u"grpc"_qs;
+        server.serviceName = proxy.value(u"grpc-opts"_qs).toMap().value(u"grpc-service-name"_qs).toString();
+    }
+    else if (!network.isEmpty() && network != u"tcp"_qs)
+    {
+        server.network.clear();
+    }
+    return server;
+}
+
+// Clash Decoder
+SubscriptionResult ClashDecoder::DecodeSubscription(const QByteArray &data) const
+{
+    const auto payloadHash = PayloadCache::Hash(data);
+    if (const auto cached = PayloadCache::Find("clash", payloadHash))
+        return *cached;
+
+    QStringList unsupportedNodes;
+    const auto result = Decode(data, unsupportedNodes);
+    ReportUnsupportedNodes(unsupportedNodes);
+    PayloadCache::Store("clash", payloadHash, result);
+    return result;
+}
+
+SubscriptionResult ClashDecoder::Decode(const QByteArray &data, QStringList &unsupportedNodes)
+{
+    // Proxies are decoded one at a time as the reader reaches them, proxy-groups and rules are skipped.
+    SubscriptionResult result;
+    SubscriptionResult::result_type_t<SR_OutboundObjects> outbounds;
+    YamlReader reader(data);
+    reader.ReadSequence("proxies", [&](const QVariant &proxy) { InsertProxyServer(outbounds, unsupportedNodes, ReadClashProxy(proxy.toMap())); });
+    result.SetValue<SR_OutboundObjects>(outbounds);
+    return result;
+}
+
+static void ReadSingBoxTls(JsonReader &reader, ProxyServer &server)
+{
+    if (!reader.EnterObject())
+    {
+        reader.Skip();
+        return;
+    }
+
+    QByteArrayView key;
+    while (reader.NextKey(key))
+    {
+        if (key == "enabled")
+            server.tls = reader.ReadBool();
+        else if (key == "server_name")
+            server.serverName = reader.ReadString();
+        else if (key == "alpn")
+            server.alpn = reader.ReadStringList();
+        else
+            reader.Skip();
+    }
+}
+
+static void ReadSingBoxTransport(JsonReader &reader, ProxyServer &server)
+{
+    if (!reader.EnterObject())
+    {
+        reader.Skip();
+        return;
+    }
+
+    QString type;
+    QByteArrayView key;
+    while (reader.NextKey(key))
+    {
+        if (key == "type")
         {
-            // SIP003 plugins not supported.
-            qDebug() << "Unsupported node:" << remarks;
-            continue;
+            type = reader.ReadString();
         }
+        else if (key == "path")
+        {
+            server.path = reader.ReadString();
+        }
+        else if (key == "service_name")
+        {
+            server.serviceName = reader.ReadString();
+        }
+        else if (key == "host")
+        {
+            // A list for the HTTP transport, some generators write a single string.
+            if (reader.Peek() == JsonReader::VALUE_STRING)
+                server.host = QStringList{ reader.ReadString() };
+            else
+                server.host = reader.ReadStringList();
+        }
+        else if (key == "headers" && reader.EnterObject())
+        {
+            QByteArrayView header;
+            while (reader.NextKey(header))
+            {
+                if (header == "Host" && server.host.isEmpty())
+                    server.host = QStringList{ reader.ReadString() };
+                else
+                    reader.Skip();
+            }
+        }
+        else
+        {
+            reader.Skip();
+        }
+    }
 
-        tags.insert(remarks, serverObj[u"tags"_qs].toVariant().toStringList());
+    if (type == u"ws"_qs || type == u"http"_qs || type == u"grpc"_qs)
+        server.network = type;
+    else
+        server.network.clear();
+}
 
-        IOProtocolSettings protocolSettings;
-        protocolSettings.insert(u"method"_qs, method);
-        protocolSettings.insert(u"password"_qs, password);
+enum SingBoxOutboundField
+{
+    SINGBOX_UNKNOWN,
+    SINGBOX_TYPE,
+    SINGBOX_TAG,
+    SINGBOX_SERVER,
+    SINGBOX_SERVER_PORT,
+    SINGBOX_METHOD,
+    SINGBOX_PASSWORD,
+    SINGBOX_USERNAME,
+    SINGBOX_UUID,
+    SINGBOX_FLOW,
+    SINGBOX_PLUGIN,
+    SINGBOX_TLS,
+    SINGBOX_TRANSPORT,
+};
 
-        IOConnectionSettings connectionSettings;
-        connectionSettings.address = server;
-        connectionSettings.port = serverObj[u"server_port"_qs].toInt();
-        connectionSettings.protocol = u"shadowsocks"_qs;
-        connectionSettings.protocolSettings = protocolSettings;
+constexpr std::pair<QByteArrayView, SingBoxOutboundField> SingBoxOutboundFields[]{
+    { "type", SINGBOX_TYPE },               //
+    { "tag", SINGBOX_TAG },                 //
+    { "server", SINGBOX_SERVER },           //
+    { "server_port", SINGBOX_SERVER_PORT }, //
+    { "method", SINGBOX_METHOD },           //
+    { "security", SINGBOX_METHOD },         //
+    { "password", SINGBOX_PASSWORD },       //
+    { "username", SINGBOX_USERNAME },       //
+    { "uuid", SINGBOX_UUID },               //
+    { "flow", SINGBOX_FLOW },               //
+    { "plugin", SINGBOX_PLUGIN },           //
+    { "tls", SINGBOX_TLS },                 //
+    { "transport", SINGBOX_TRANSPORT },
+};
 
-        outbounds.insert(remarks, { connectionSettings });
+static ProxyServer ReadSingBoxOutbound(JsonReader &reader)
+{
+    ProxyServer server;
+    if (!reader.EnterObject())
+    {
+        reader.Skip();
+        return server;
     }
-    result.SetValue<SR_Tags>(tags);
+
+    QByteArrayView key;
+    while (reader.NextKey(key))
+    {
+        const auto field = std::find_if(std::begin(SingBoxOutboundFields), std::end(SingBoxOutboundFields), [key](const auto &f) { return f.first == key; });
+        switch (field == std::end(SingBoxOutboundFields) ? SINGBOX_UNKNOWN : field->second)
+        {
+            case SINGBOX_TYPE: server.protocol = reader.ReadString(); break;
+            case SINGBOX_TAG: server.name = reader.ReadString(); break;
+            case SINGBOX_SERVER: server.address = reader.ReadString(); break;
+            case SINGBOX_SERVER_PORT: server.port = reader.ReadInt(); break;
+            case SINGBOX_METHOD: server.method = reader.ReadString(); break;
+            case SINGBOX_PASSWORD: server.password = reader.ReadString(); break;
+            case SINGBOX_USERNAME: server.username = reader.ReadString(); break;
+            case SINGBOX_UUID: server.uuid = reader.ReadString(); break;
+            case SINGBOX_FLOW: server.flow = reader.ReadString(); break;
+            case SINGBOX_PLUGIN: server.hasPlugin = !reader.ReadString().isEmpty(); break;
+            case SINGBOX_TLS: ReadSingBoxTls(reader, server); break;
+            case SINGBOX_TRANSPORT: ReadSingBoxTransport(reader, server); break;
+            case SINGBOX_UNKNOWN: reader.Skip(); break;
+        }
+    }
+    return server;
+}
+
+// sing-box Decoder
+SubscriptionResult SingBoxDecoder::DecodeSubscription(const QByteArray &data) const
+{
+    const auto payloadHash = PayloadCache::Hash(data);
+    if (const auto cached = PayloadCache::Find("sing_box", payloadHash))
+        return *cached;
+
+    QStringList unsupportedNodes;
+    const auto result = Decode(data, unsupportedNodes);
+    ReportUnsupportedNodes(unsupportedNodes);
+    PayloadCache::Store("sing_box", payloadHash, result);
+    return result;
+}
+
+SubscriptionResult SingBoxDecoder::Decode(const QByteArray &data, QStringList &unsupportedNodes)
+{
+    // Outbounds which only route to other outbounds.
+    static const QStringList nonProxyTypes{ u"selector"_qs, u"urltest"_qs, u"direct"_qs, u"block"_qs, u"dns"_qs };
+
+    SubscriptionResult result;
+    SubscriptionResult::result_type_t<SR_OutboundObjects> outbounds;
+    ReadRootArray(data, "outbounds",
+                  [&](JsonReader &reader)
+                  {
+                      const auto server = ReadSingBoxOutbound(reader);
+                      if (!nonProxyTypes.contains(server.protocol))
+                          InsertProxyServer(outbounds, unsupportedNodes, server);
+                  });
     result.SetValue<SR_OutboundObjects>(outbounds);
     return result;
 }
@@ -132,47 +607,40 @@ SubscriptionResult OOCProvider::FetchDecodeSubscription(const SubscriptionProvid
     {
         qCritical().noquote() << errorString;
         InternalSubscriptionSupportPlugin::ShowMessageBox(QObject::tr("Cannot Contact OOC API Server"), errorString);
-        return {};
+        // Keep the servers of the last successful refresh rather than emptying the group.
+        return PayloadCache::FindLast("ooc", QUrl{ url }).value_or(SubscriptionResult{});
     }
 
-    const auto shadowsocks = QJsonDocument::fromJson(data).object().value(u"shadowsocks"_qs).toArray();
+    // A body identical to the previous one is not decoded again.
+    const auto payloadHash = PayloadCache::Hash(data);
+    if (const auto cached = PayloadCache::Find("ooc", payloadHash, QUrl{ url }))
+        return *cached;
 
     SubscriptionResult result;
     SubscriptionResult::result_type_t<SR_Tags> tags;
     SubscriptionResult::result_type_t<SR_OutboundObjects> outbounds;
 
     QStringList unsupportedNodes;
-    for (const auto &ss : shadowsocks)
-    {
-        // id, group, owner omitted.
-        const auto name = ss[u"name"_qs].toString();
-        if (ss.toObject().contains(u"pluginName"_qs))
-        {
-            // SIP003 plugins not supported.
-            qWarning() << "Unsupported node:" << name;
-            unsupportedNodes << name;
-            continue;
-        }
-
-        tags.insert(name, ss[u"tags"_qs].toVariant().toStringList());
+    ReadShadowsocksServers(data, "shadowsocks",
+                           [&](const ShadowsocksServer &server)
+                           {
+                               // id, group, owner omitted.
+                               if (server.plugin)
+                               {
+                                   // SIP003 plugins not supported.
+                                   qWarning() << "Unsupported node:" << server.name;
+                                   unsupportedNodes << server.name;
+                                   return;
+                               }
 
-        IOProtocolSettings protocolSettings;
-        protocolSettings.insert(u"method"_qs, ss[u"method"_qs].toString());
-        protocolSettings.insert(u"password"_qs, ss[u"password"_qs].toString());
+                               tags.insert(server.name, server.tags);
+                               outbounds.insert(server.name, { server.connectionSettings });
+                           });
 
-        IOConnectionSettings connectionSettings;
-        connectionSettings.address = ss[u"address"_qs].toString();
-        connectionSettings.port = ss[u"port"_qs].toInt();
-        connectionSettings.protocol = u"shadowsocks"_qs;
-        connectionSettings.protocolSettings = protocolSettings;
-
-        outbounds.insert(name, { connectionSettings });
-    }
-
-    if (!unsupportedNodes.isEmpty())
-        InternalSubscriptionSupportPlugin::ShowMessageBox(QObject::tr("Subscription contains unsupported nodes"), unsupportedNodes.join('\n'));
+    ReportUnsupportedNodes(unsupportedNodes);
 
     result.SetValue<SR_Tags>(tags);
     result.SetValue<SR_OutboundObjects>(outbounds);
+    PayloadCache::Store("ooc", payloadHash, result, QUrl{ url });
     return result;
 }
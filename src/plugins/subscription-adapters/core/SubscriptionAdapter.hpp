@@ -17,6 +17,24 @@ class SimpleBase64Decoder : public SubscriptionProvider
     SubscriptionResult DecodeSubscription(const QByteArray &data) const override;
 };
 
+class ClashDecoder : public SubscriptionProvider
+{
+  public:
+    SubscriptionResult DecodeSubscription(const QByteArray &data) const override;
+    // Decodes the payload without looking it up in the payload cache. Proxies which cannot be represented are skipped and
+    // their names added to unsupportedNodes.
+    static SubscriptionResult Decode(const QByteArray &data, QStringList &unsupportedNodes);
+};
+
+class SingBoxDecoder : public SubscriptionProvider
+{
+  public:
+    SubscriptionResult DecodeSubscription(const QByteArray &data) const override;
+    // Decodes the payload without looking it up in the payload cache. Proxies which cannot be represented are skipped and
+    // their names added to unsupportedNodes.
+    static SubscriptionResult Decode(const QByteArray &data, QStringList &unsupportedNodes);
+};
+
 class OOCProvider : public SubscriptionProvider
 {
   public:
@@ -46,6 +64,8 @@ class BuiltinSubscriptionAdapterInterface : public IPluginSubscriptionInterface
         return {
             SubscriptionProviderInfo::CreateDecoder<SIP008Decoder>(SubscriptionProviderId{ "sip008" }, "SIP008"),
             SubscriptionProviderInfo::CreateDecoder<SimpleBase64Decoder>(SubscriptionProviderId{ "simple_base64" }, "Base64 Links"),
+            SubscriptionProviderInfo::CreateDecoder<ClashDecoder>(SubscriptionProviderId{ "clash" }, "Clash Proxies"),
+            SubscriptionProviderInfo::CreateDecoder<SingBoxDecoder>(SubscriptionProviderId{ "sing_box" }, "sing-box Outbounds"),
             SubscriptionProviderInfo::CreateFetcherDecoder<OOCProvider>(SubscriptionProviderId{ "ooc" }, "Open Online Config", oocv1_options),
         };
     }
@@ -0,0 +1,452 @@
+#include "YamlReader.hpp"
+
+#include <algorithm>
+
+static bool IsSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+static QByteArrayView Trimmed(QByteArrayView text)
+{
+    while (!text.isEmpty() && IsSpace(text.front()))
+        text = text.sliced(1);
+    while (!text.isEmpty() && IsSpace(text.back()))
+        text.chop(1);
+    return text;
+}
+
+static void SkipSpaces(QByteArrayView text, qsizetype &pos)
+{
+    while (pos < text.size() && IsSpace(text[pos]))
+        pos++;
+}
+
+// A quote only starts a quoted scalar at the beginning of a token, "it's" is a plain scalar.
+static bool StartsQuote(QByteArrayView text, qsizetype pos)
+{
+    if (text[pos] != '"' && text[pos] != '\'')
+        return false;
+    return pos == 0 || IsSpace(text[pos - 1]) || text[pos - 1] == ',' || text[pos - 1] == '[' || text[pos - 1] == '{' || text[pos - 1] == ':';
+}
+
+// Returns the position after the closing quote of the quoted scalar at pos, or the end of the text.
+static qsizetype SkipQuoted(QByteArrayView text, qsizetype pos, bool *closed = nullptr)
+{
+    const auto quote = text[pos++];
+    while (pos < text.size())
+    {
+        const auto ch = text[pos++];
+        if (quote == '"' && ch == '\\')
+            pos++;
+        else if (quote == '\'' && ch == quote && pos < text.size() && text[pos] == quote)
+            pos++;
+        else if (ch == quote)
+        {
+            if (closed)
+                *closed = true;
+            return pos;
+        }
+    }
+    if (closed)
+        *closed = false;
+    return text.size();
+}
+
+static QString ReadQuoted(QByteArrayView text, qsizetype &pos)
+{
+    const auto quote = text[pos++];
+    QByteArray value;
+    while (pos < text.size())
+    {
+        const auto ch = text[pos++];
+        if (ch == quote)
+        {
+            // '' is an escaped quote in a single-quoted scalar.
+            if (quote == '\'' && pos < text.size() && text[pos] == '\'')
+            {
+                value.append('\'');
+                pos++;
+                continue;
+            }
+            break;
+        }
+
+        if (quote != '"' || ch != '\\' || pos >= text.size())
+        {
+            value.append(ch);
+            continue;
+        }
+
+        switch (const auto escaped = text[pos++]; escaped)
+        {
+            case 'n': value.append('\n'); break;
+            case 't': value.append('\t'); break;
+            case 'r': value.append('\r'); break;
+            case '0': value.append('\0'); break;
+            case 'x':
+            case 'u':
+            case 'U':
+            {
+                const qsizetype digits = escaped == 'x' ? 2 : escaped == 'u' ? 4 : 8;
+                bool ok = false;
+                const char32_t codePoint = QByteArray::fromRawData(text.data() + pos, std::min(digits, text.size() - pos)).toUInt(&ok, 16);
+                if (ok)
+                {
+                    value.append(QString::fromUcs4(&codePoint, 1).toUtf8());
+                    pos += digits;
+                }
+                break;
+            }
+            default: value.append(escaped); break;
+        }
+    }
+    return QString::fromUtf8(value);
+}
+
+static bool IsQuoted(QByteArrayView text)
+{
+    return !text.isEmpty() && StartsQuote(text, 0);
+}
+
+// Whether the quoted scalar the text starts with ends in it.
+static bool IsClosed(QByteArrayView text)
+{
+    bool closed = false;
+    SkipQuoted(text, 0, &closed);
+    return closed;
+}
+
+static QByteArrayView StripComment(QByteArrayView line)
+{
+    for (qsizetype i = 0; i < line.size();)
+    {
+        if (StartsQuote(line, i))
+        {
+            i = SkipQuoted(line, i);
+            continue;
+        }
+        if (line[i] == '#' && (i == 0 || IsSpace(line[i - 1])))
+            return line.first(i);
+        i++;
+    }
+    return line;
+}
+
+static bool IsBalanced(QByteArrayView text)
+{
+    auto depth = 0;
+    for (qsizetype i = 0; i < text.size();)
+    {
+        if (StartsQuote(text, i))
+        {
+            i = SkipQuoted(text, i);
+            continue;
+        }
+        if (text[i] == '{' || text[i] == '[')
+            depth++;
+        else if (text[i] == '}' || text[i] == ']')
+            depth--;
+        i++;
+    }
+    return depth <= 0;
+}
+
+void YamlReader::Advance()
+{
+    current = {};
+    while (pos < data.size())
+    {
+        const auto end = std::find(data.begin() + pos, data.end(), '\n') - data.begin();
+        const auto line = data.sliced(pos, end - pos);
+        pos = end + 1;
+
+        qsizetype indent = 0;
+        while (indent < line.size() && (line[indent] == ' ' || line[indent] == '\t'))
+            indent++;
+
+        const auto content = Trimmed(StripComment(line.sliced(indent)));
+        if (content.isEmpty() || (indent == 0 && (content == "---" || content == "...")))
+            continue;
+
+        current = { true, indent, content };
+        return;
+    }
+}
+
+bool YamlReader::IsSequenceItem(QByteArrayView content)
+{
+    return content == "-" || content.startsWith("- ") || content.startsWith("-\t");
+}
+
+qsizetype YamlReader::FindMappingColon(QByteArrayView content)
+{
+    if (content.startsWith('{') || content.startsWith('['))
+        return -1;
+
+    for (qsizetype i = 0; i < content.size();)
+    {
+        if (StartsQuote(content, i))
+        {
+            i = SkipQuoted(content, i);
+            continue;
+        }
+        if (content[i] == ':' && (i + 1 == content.size() || IsSpace(content[i + 1])))
+            return i;
+        i++;
+    }
+    return -1;
+}
+
+QString YamlReader::ParseScalar(QByteArrayView text)
+{
+    text = Trimmed(text);
+    if (!text.isEmpty() && StartsQuote(text, 0))
+    {
+        qsizetype quotedPos = 0;
+        return ReadQuoted(text, quotedPos);
+    }
+    if (text == "~" || text == "null")
+        return {};
+    return QString::fromUtf8(text);
+}
+
+QString YamlReader::ParseFlowScalar(QByteArrayView text, qsizetype &pos, bool isKey)
+{
+    SkipSpaces(text, pos);
+    if (pos < text.size() && (text[pos] == '"' || text[pos] == '\''))
+        return ReadQuoted(text, pos);
+
+    const auto begin = pos;
+    while (pos < text.size())
+    {
+        const auto ch = text[pos];
+        if (ch == ',' || ch == ']' || ch == '}')
+            break;
+        // Values such as URLs may contain colons, only a key ends at one.
+        if (isKey && ch == ':' && (pos + 1 == text.size() || IsSpace(text[pos + 1]) || text[pos + 1] == ',' || text[pos + 1] == '}' || text[pos + 1] == ']'))
+            break;
+        pos++;
+    }
+    return ParseScalar(text.sliced(begin, pos - begin));
+}
+
+QVariant YamlReader::ParseFlow(QByteArrayView text, qsizetype &pos)
+{
+    SkipSpaces(text, pos);
+    if (pos >= text.size())
+        return {};
+
+    if (text[pos] == '{')
+    {
+        pos++;
+        QVariantMap map;
+        while (pos < text.size())
+        {
+            SkipSpaces(text, pos);
+            const auto start = pos;
+            if (pos < text.size() && text[pos] == '}')
+            {
+                pos++;
+                break;
+            }
+            if (pos < text.size() && text[pos] == ',')
+            {
+                pos++;
+                continue;
+            }
+
+            const auto key = ParseFlowScalar(text, pos, true);
+            SkipSpaces(text, pos);
+            QVariant value;
+            if (pos < text.size() && text[pos] == ':')
+            {
+                pos++;
+                SkipSpaces(text, pos);
+                if (pos < text.size() && text[pos] != ',' && text[pos] != '}')
+                    value = ParseFlow(text, pos);
+            }
+            map.insert(key, value);
+
+            // Stray characters are dropped rather than looped over.
+            if (pos == start)
+                pos++;
+        }
+        return map;
+    }
+
+    if (text[pos] == '[')
+    {
+        pos++;
+        QVariantList list;
+        while (pos < text.size())
+        {
+            SkipSpaces(text, pos);
+            const auto start = pos;
+            if (pos < text.size() && text[pos] == ']')
+            {
+                pos++;
+                break;
+            }
+            if (pos < text.size() && text[pos] == ',')
+            {
+                pos++;
+                continue;
+            }
+
+            list << ParseFlow(text, pos);
+            if (pos == start)
+                pos++;
+        }
+        return list;
+    }
+
+    return ParseFlowScalar(text, pos, false);
+}
+
+QVariant YamlReader::ParseInlineValue(QByteArrayView value, qsizetype indent)
+{
+    if (value.startsWith('{') || value.startsWith('['))
+    {
+        // Flow collections may continue on the following lines.
+        auto text = value.toByteArray();
+        Advance();
+        while (!IsBalanced(text) && current.valid)
+        {
+            text.append(' ');
+            text.append(current.content.data(), current.content.size());
+            Advance();
+        }
+
+        qsizetype flowPos = 0;
+        return ParseFlow(text, flowPos);
+    }
+
+    Advance();
+    // Long scalars are folded onto the following, deeper indented, lines.
+    const auto isContinuation = [this, indent](QByteArrayView text)
+    {
+        if (!current.valid || current.indent <= indent)
+            return false;
+        return IsQuoted(text) ? !IsClosed(text) : FindMappingColon(current.content) < 0 && !IsSequenceItem(current.content);
+    };
+    if (!isContinuation(value))
+        return ParseScalar(value);
+
+    auto text = value.toByteArray();
+    while (isContinuation(text))
+    {
+        text.append(' ');
+        text.append(current.content.data(), current.content.size());
+        Advance();
+    }
+    return ParseScalar(text);
+}
+
+QVariant YamlReader::ParseBlock(qsizetype indent)
+{
+    if (!current.valid || current.indent != indent)
+        return {};
+
+    if (IsSequenceItem(current.content))
+    {
+        QVariantList list;
+        while (current.valid && current.indent == indent && IsSequenceItem(current.content))
+            list << ParseSequenceItem(indent);
+        return list;
+    }
+
+    if (FindMappingColon(current.content) >= 0)
+        return ParseBlockMapping(indent);
+
+    return ParseInlineValue(current.content, indent);
+}
+
+QVariant YamlReader::ParseSequenceItem(qsizetype indent)
+{
+    auto rest = current.content.sliced(1);
+    qsizetype spaces = 0;
+    while (spaces < rest.size() && IsSpace(rest[spaces]))
+        spaces++;
+    rest = rest.sliced(spaces);
+
+    if (rest.isEmpty())
+    {
+        Advance();
+        return current.valid && current.indent > indent ? ParseBlock(current.indent) : QVariant{};
+    }
+
+    // "- key: value" starts a mapping whose keys are aligned with the first one.
+    current.content = rest;
+    current.indent = indent + 1 + spaces;
+    return ParseBlock(current.indent);
+}
+
+QVariantMap YamlReader::ParseBlockMapping(qsizetype indent)
+{
+    QVariantMap map;
+    while (current.valid && current.indent >= indent)
+    {
+        // Continuation lines of unsupported multi-line scalars.
+        if (current.indent > indent)
+        {
+            Advance();
+            continue;
+        }
+        if (IsSequenceItem(current.content))
+            break;
+
+        const auto colon = FindMappingColon(current.content);
+        if (colon < 0)
+        {
+            Advance();
+            continue;
+        }
+
+        const auto key = ParseScalar(current.content.first(colon));
+        const auto value = Trimmed(current.content.sliced(colon + 1));
+        if (!value.isEmpty())
+        {
+            map.insert(key, ParseInlineValue(value, indent));
+            continue;
+        }
+
+        Advance();
+        // A sequence may be indented as deep as its key.
+        if (current.valid && (current.indent > indent || (current.indent == indent && IsSequenceItem(current.content))))
+            map.insert(key, ParseBlock(current.indent));
+        else
+            map.insert(key, QVariant{});
+    }
+    return map;
+}
+
+void YamlReader::ReadSequence(QByteArrayView key, const std::function<void(const QVariant &)> &onItem)
+{
+    Advance();
+    while (current.valid)
+    {
+        const auto colon = current.indent == 0 ? FindMappingColon(current.content) : -1;
+        if (colon < 0 || ParseScalar(current.content.first(colon)) != QString::fromUtf8(key))
+        {
+            Advance();
+            continue;
+        }
+
+        if (const auto value = Trimmed(current.content.sliced(colon + 1)); !value.isEmpty())
+        {
+            for (const auto &item : ParseInlineValue(value, 0).toList())
+                onItem(item);
+            return;
+        }
+
+        Advance();
+        if (!current.valid || !IsSequenceItem(current.content))
+            return;
+
+        const auto indent = current.indent;
+        while (current.valid && current.indent == indent && IsSequenceItem(current.content))
+            onItem(ParseSequenceItem(indent));
+        return;
+    }
+}
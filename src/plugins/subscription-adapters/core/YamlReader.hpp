@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QVariant>
+#include <functional>
+
+// Reads the subset of YAML that Clash configurations are written in: block mappings and sequences, flow mappings and
+// sequences, plain and quoted scalars, also folded over several lines, and comments. Scalars are read as strings.
+// Anchors, tags, block scalars and multiple documents are not supported.
+// Only one item of the requested sequence is held at a time, the rest of the document is skipped line by line.
+class YamlReader
+{
+  public:
+    explicit YamlReader(QByteArrayView data) : data(data){};
+    // Calls onItem for every item of the sequence under the top-level key.
+    void ReadSequence(QByteArrayView key, const std::function<void(const QVariant &)> &onItem);
+
+  private:
+    struct Line
+    {
+        bool valid = false;
+        qsizetype indent = 0;
+        // Without indentation, trailing whitespace and comments.
+        QByteArrayView content;
+    };
+
+    void Advance();
+    QVariant ParseBlock(qsizetype indent);
+    QVariant ParseSequenceItem(qsizetype indent);
+    QVariantMap ParseBlockMapping(qsizetype indent);
+    QVariant ParseInlineValue(QByteArrayView value, qsizetype indent);
+
+    static QVariant ParseFlow(QByteArrayView text, qsizetype &pos);
+    static QString ParseFlowScalar(QByteArrayView text, qsizetype &pos, bool isKey);
+    static QString ParseScalar(QByteArrayView text);
+    static qsizetype FindMappingColon(QByteArrayView content);
+    static bool IsSequenceItem(QByteArrayView content);
+
+  private:
+    QByteArrayView data;
+    qsizetype pos = 0;
+    Line current;
+};
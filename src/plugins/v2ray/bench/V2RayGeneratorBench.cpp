@@ -0,0 +1,223 @@
+#include "AllocationCounter.hpp"
+#include "BuiltinV2RayCorePlugin.hpp"
+#include "Qv2rayApplication.hpp"
+#include "V2RayModels.hpp"
+#include "core/V2RayProfileGenerator.hpp"
+#include "plugins/internal/InternalProfilePreprocessor.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <array>
+#include <functional>
+
+#ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
+constexpr auto GENERATOR_NAME = "protobuf";
+#else
+constexpr auto GENERATOR_NAME = "JSON";
+#endif
+
+using namespace Qv2ray::Models;
+
+// Every outbound is a VMess server over WebSocket and TLS, the rules alternate between domain and IP lists so that both
+// matchers are generated. Geo references are left out, the benchmark must not depend on the assets.
+static ProfileContent GenerateProfile(int inbounds, int outbounds, int rules, int entriesPerRule)
+{
+    ProfileContent profile;
+    for (auto i = 0; i < inbounds; i++)
+    {
+        InboundObject in;
+        in.name = u"in-%1"_qs.arg(i);
+        in.inboundSettings.protocol = i % 2 ? u"http"_qs : u"socks"_qs;
+        in.inboundSettings.address = u"127.0.0.1"_qs;
+        in.inboundSettings.port = 10000 + i;
+        profile.inbounds << in;
+    }
+
+    for (auto i = 0; i < outbounds; i++)
+    {
+        VMessClientObject client;
+        client.id = u"%1-0000-4000-a000-000000000000"_qs.arg(i, 8, 16, QChar(u'0'));
+
+        StreamSettingsObject stream;
+        stream.network = u"ws"_qs;
+        stream.security = u"tls"_qs;
+        stream.tlsSettings->serverName = u"node-%1.example.com"_qs.arg(i);
+        stream.wsSettings->path = u"/ws/%1"_qs.arg(i);
+
+        OutboundObject out{ IOConnectionSettings{ u"vmess"_qs, u"node-%1.example.com"_qs.arg(i), 443 } };
+        out.name = u"out-%1"_qs.arg(i);
+        out.outboundSettings.protocolSettings = IOProtocolSettings{ client.toJson() };
+        out.outboundSettings.streamSettings = IOStreamSettings{ stream.toJson() };
+        profile.outbounds << out;
+    }
+
+    for (auto i = 0; i < rules; i++)
+    {
+        RuleObject rule;
+        rule.outboundTag = u"out-%1"_qs.arg(i % std::max(outbounds, 1));
+        for (auto j = 0; j < entriesPerRule; j++)
+        {
+            if (i % 2)
+                rule.targetIPs << u"10.%1.%2.0/24"_qs.arg(i % 256).arg(j % 256);
+            else
+                rule.targetDomains << (j % 2 ? u"domain:site-%1-%2.example"_qs : u"full:www.site-%1-%2.example"_qs).arg(i).arg(j);
+        }
+        profile.routing.rules << rule;
+    }
+    return profile;
+}
+
+// A single outbound with no inbound and no rule, which the preprocessor completes with the default inbounds and the rules
+// of the route matrix. Half of the IP entries overlap the other half, so that the lists have something to aggregate.
+static ProfileContent GenerateRouteMatrixProfile(int entries)
+{
+    VMessClientObject client;
+    client.id = u"00000000-0000-4000-a000-000000000000"_qs;
+    OutboundObject out{ IOConnectionSettings{ u"vmess"_qs, u"node.example.com"_qs, 443 } };
+    out.outboundSettings.protocolSettings = IOProtocolSettings{ client.toJson() };
+
+    std::array<QStringList, 3> domains;
+    std::array<QStringList, 3> ips;
+    for (auto i = 0; i < entries; i++)
+    {
+        domains[i % 3] << u"domain:site-%1.example"_qs.arg(i);
+        ips[i % 3] << (i % 2 ? u"10.%1.%2.0/24"_qs.arg(i / 256 % 256).arg(i % 256) : u"10.%1.0.0/16"_qs.arg(i / 256 % 256));
+    }
+
+    ProfileContent profile;
+    profile.outbounds << out;
+    profile.routing.extraOptions.insert(RouteMatrixConfig::EXTRA_OPTIONS_ID, RouteMatrixConfig{ { domains[0], domains[1], domains[2] }, { ips[0], ips[1], ips[2] } }.toJson());
+    return profile;
+}
+
+// Runs the stage once untimed, as the first run may load what the later ones share, then times it.
+static void Time(const char *stage, int iterations, const std::function<void()> &run)
+{
+    run();
+
+    QList<qint64> times;
+    times.reserve(iterations);
+    const auto allocationsBefore = AllocationCount();
+    for (auto i = 0; i < iterations; i++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        times << timer.nsecsElapsed();
+    }
+    const auto allocations = (AllocationCount() - allocationsBefore) / iterations;
+    std::sort(times.begin(), times.end());
+
+    QTextStream(stdout) << stage << ": median " << times[times.size() / 2] / 1e6 << " ms, min " << times.first() / 1e6 << " ms, " << allocations
+                        << " operator new allocations per run (Qt container storage is allocated with malloc and not counted)." << Qt::endl;
+}
+
+// The first run records the golden configuration, later runs fail on any difference, with the offset of the first one.
+static bool CheckGolden(const QString &path, const QByteArray &config)
+{
+    QFile golden(path);
+    if (!golden.exists())
+    {
+        QDir().mkpath(QFileInfo(golden).absolutePath());
+        if (!golden.open(QIODevice::WriteOnly) || golden.write(config) != config.size())
+        {
+            QTextStream(stderr) << "Cannot record the golden configuration: " << path << Qt::endl;
+            return false;
+        }
+        QTextStream(stdout) << "Recorded the golden configuration: " << path << Qt::endl;
+        return true;
+    }
+
+    if (!golden.open(QIODevice::ReadOnly))
+    {
+        QTextStream(stderr) << "Cannot read the golden configuration: " << path << Qt::endl;
+        return false;
+    }
+
+    const auto expected = golden.readAll();
+    if (expected == config)
+        return true;
+
+    const auto offset = std::mismatch(expected.begin(), expected.end(), config.begin(), config.end()).first - expected.begin();
+    QTextStream(stderr) << "The generated configuration differs from " << path << " at byte " << offset << ", " << config.size() << " bytes instead of "
+                        << expected.size() << "." << Qt::endl;
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Times the V2Ray configuration generator on a synthetic profile."_qs);
+    parser.addHelpOption();
+
+    const QCommandLineOption inboundsOption(u"inbounds"_qs, u"Number of inbounds."_qs, u"count"_qs, u"4"_qs);
+    const QCommandLineOption outboundsOption(u"outbounds"_qs, u"Number of outbounds."_qs, u"count"_qs, u"200"_qs);
+    const QCommandLineOption rulesOption(u"rules"_qs, u"Number of routing rules."_qs, u"count"_qs, u"1000"_qs);
+    const QCommandLineOption entriesOption(u"entries"_qs, u"Domains or IPs per routing rule."_qs, u"count"_qs, u"20"_qs);
+    const QCommandLineOption iterationsOption(u"iterations"_qs, u"Number of timed generations."_qs, u"count"_qs, u"20"_qs);
+    const QCommandLineOption goldenOption(u"golden"_qs, u"Compare the configuration generated from a small preprocessed profile with the file, or record it."_qs,
+                                          u"file"_qs);
+    parser.addOptions({ inboundsOption, outboundsOption, rulesOption, entriesOption, iterationsOption, goldenOption });
+    parser.process(app);
+
+    // The generator reads the plugin settings through the instance, which the constructor registers. The preprocessor
+    // reads the application settings, the defaults except for the geo data rules, the benchmark must not depend on the
+    // assets.
+    BuiltinV2RayCorePlugin plugin;
+    Qv2rayApplicationConfigObject config;
+    config.connectionConfig->BypassCN = false;
+    config.connectionConfig->BypassLAN = false;
+    GlobalConfig = &config;
+
+    InternalProfilePreprocessor preprocessor;
+    QMap<QString, QString> tagProtocolMap;
+    if (parser.isSet(goldenOption))
+    {
+        const auto profile = preprocessor.PreprocessProfile(GenerateRouteMatrixProfile(12));
+        return CheckGolden(parser.value(goldenOption), V2RayProfileGenerator::GenerateConfiguration(profile, tagProtocolMap)) ? 0 : 1;
+    }
+
+    const auto inbounds = parser.value(inboundsOption).toInt();
+    const auto outbounds = parser.value(outboundsOption).toInt();
+    const auto rules = parser.value(rulesOption).toInt();
+    const auto entries = parser.value(entriesOption).toInt();
+    const auto iterations = std::max(parser.value(iterationsOption).toInt(), 1);
+
+    const auto matrixProfile = GenerateRouteMatrixProfile(rules * entries);
+    const auto preprocessed = preprocessor.PreprocessProfile(matrixProfile);
+    QTextStream(stdout) << "Preprocessor, " << rules * entries << " route matrix entries: " << preprocessed.inbounds.size() << " inbounds, "
+                        << preprocessed.outbounds.size() << " outbounds, " << preprocessed.routing.rules.size() << " rules." << Qt::endl;
+    Time("  preprocessing", iterations, [&] { preprocessor.PreprocessProfile(matrixProfile); });
+
+    const auto profile = GenerateProfile(inbounds, outbounds, rules, entries);
+    const auto size = V2RayProfileGenerator::GenerateConfiguration(profile, tagProtocolMap).size();
+    if (size == 0)
+    {
+        QTextStream(stderr) << "The generator produced an empty configuration." << Qt::endl;
+        return 1;
+    }
+
+    QTextStream(stdout) << GENERATOR_NAME << " generator, " << profile.inbounds.size() << " inbounds, " << profile.outbounds.size() << " outbounds, "
+                        << profile.routing.rules.size() << " rules: " << size << " bytes." << Qt::endl;
+    Time("  generation, unchanged profile", iterations, [&] { V2RayProfileGenerator::GenerateConfiguration(profile, tagProtocolMap); });
+
+    // Equal profiles whose sections share no data with the previous one, as after an edit, nothing is reused.
+    QList<ProfileContent> copies;
+    for (auto i = 0; i <= iterations; i++)
+    {
+        auto copy = profile;
+        copy.inbounds = QList<InboundObject>{ profile.inbounds.cbegin(), profile.inbounds.cend() };
+        copy.outbounds = QList<OutboundObject>{ profile.outbounds.cbegin(), profile.outbounds.cend() };
+        copy.routing.rules = QList<RuleObject>{ profile.routing.rules.cbegin(), profile.routing.rules.cend() };
+        copies << copy;
+    }
+    Time("  generation, new profile", iterations, [&, i = 0]() mutable { V2RayProfileGenerator::GenerateConfiguration(copies[i++], tagProtocolMap); });
+    return 0;
+}
@@ -23,6 +23,14 @@ struct ObservatoryConfig
     QJS_JSON(F(subjectSelector))
 };
 
+struct LogFileConfig
+{
+    Bindable<bool> enabled{ false };
+    Bindable<int> maxFileSize{ 16 };
+    Bindable<int> maxFiles{ 10 };
+    QJS_JSON(P(enabled, maxFileSize, maxFiles))
+};
+
 struct V2RayCorePluginSettings
 {
     enum V2RayLogLevel
@@ -46,6 +54,7 @@ struct V2RayCorePluginSettings
 
     BrowserForwarderConfig BrowserForwarderSettings;
     ObservatoryConfig ObservatorySettings;
+    LogFileConfig LogFileSettings;
 
-    QJS_JSON(P(LogLevel, CorePath, AssetsPath, APIEnabled, APIPort, OutboundMark), F(BrowserForwarderSettings, ObservatorySettings))
+    QJS_JSON(P(LogLevel, CorePath, AssetsPath, APIEnabled, APIPort, OutboundMark), F(BrowserForwarderSettings, ObservatorySettings, LogFileSettings))
 };
@@ -2,19 +2,58 @@
 
 #include "BuiltinV2RayCorePlugin.hpp"
 #include "V2RayAPIStats.hpp"
+#include "V2RayLogWriter.hpp"
 #include "V2RayProfileGenerator.hpp"
 #include "common/CommonHelpers.hpp"
 
-#include <QJsonDocument>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QPointer>
 #include <QProcess>
+#include <QSaveFile>
+#include <QThreadPool>
 
+#ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
+constexpr auto GENERATED_V2RAY_CONFIGURATION_NAME = "config.pb";
+#else
 constexpr auto GENERATED_V2RAY_CONFIGURATION_NAME = "config.json";
+#endif
 constexpr auto V2RAYPLUGIN_NO_API_ENV = "V2RAYPLUGIN_NO_API";
+constexpr auto V2RAY_VALIDATION_POLL_INTERVAL_MS = 100;
+constexpr auto V2RAY_PREPARATION_CANCELLED = "Superseded by a newer connection request.";
+
+#ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
+// The binary config is piped through stdin, line endings must be left untouched.
+constexpr QIODevice::OpenMode V2RAY_PROCESS_OPEN_MODE = QIODevice::ReadWrite;
+#else
+constexpr QIODevice::OpenMode V2RAY_PROCESS_OPEN_MODE = QIODevice::ReadWrite | QIODevice::Text;
+#endif
+
+// The configuration is always fed through stdin, nothing needs to be written to the disk.
+static QStringList ConfigurationArguments()
+{
+#ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
+    return { u"-format=pb"_qs, u"-config"_qs, u"stdin:"_qs };
+#else
+    return { u"-config"_qs, u"stdin:"_qs };
+#endif
+}
 
 V2RayKernel::V2RayKernel()
 {
     vProcess = new QProcess();
-    connect(vProcess, &QProcess::readyReadStandardOutput, this, [&]() { emit OnLog(QString::fromUtf8(vProcess->readAllStandardOutput().trimmed())); });
+    connect(vProcess, &QProcess::readyReadStandardOutput, this,
+            [&]()
+            {
+                const auto output = vProcess->readAllStandardOutput();
+                if (logWriter)
+                    logWriter->Write(output);
+                emit OnLog(QString::fromUtf8(output.trimmed()));
+            });
     connect(vProcess, &QProcess::stateChanged,
             [this](QProcess::ProcessState state)
             {
@@ -30,44 +69,190 @@ V2RayKernel::V2RayKernel()
 
 V2RayKernel::~V2RayKernel()
 {
+    ++*preparationGeneration;
+    delete logWriter;
     delete apiWorker;
     delete vProcess;
 }
 
 void V2RayKernel::SetProfileContent(const ProfileContent &content)
 {
-    profile = content;
+    // The only copy the kernel makes, preparations share it instead of copying it again.
+    profile = std::make_shared<const ProfileContent>(content);
 }
 
-bool V2RayKernel::PrepareConfigurations()
+// Runs "-test" on the configuration, the check is abandoned as soon as the preparation is cancelled.
+static std::optional<QString> ValidateConfig(const QByteArray &config, const V2RayCorePluginSettings &settings, const std::function<bool()> &isCancelled,
+                                             const std::function<void(const QString &)> &progress)
+{
+    if (const auto &[result, msg] = ValidateKernel(settings.CorePath, settings.AssetsPath); result)
+    {
+        progress(u"V2Ray version: "_qs + *msg);
+        // Append assets location env.
+        auto env = QProcessEnvironment::systemEnvironment();
+        env.insert(u"v2ray.location.asset"_qs, settings.AssetsPath);
+
+        QProcess process;
+        process.setProcessEnvironment(env);
+        process.setProcessChannelMode(QProcess::MergedChannels);
+        progress(u"Starting V2Ray core with test options"_qs);
+        process.start(settings.CorePath, QStringList{ u"-test"_qs } + ConfigurationArguments(), V2RAY_PROCESS_OPEN_MODE);
+        process.waitForStarted();
+        process.write(config);
+        process.closeWriteChannel();
+        while (!process.waitForFinished(V2RAY_VALIDATION_POLL_INTERVAL_MS) && process.state() != QProcess::NotRunning)
+        {
+            if (isCancelled())
+            {
+                process.kill();
+                process.waitForFinished();
+                return QString::fromUtf8(V2RAY_PREPARATION_CANCELLED);
+            }
+        }
+
+        if (process.exitCode() != 0)
+        {
+            const auto output = QString::fromUtf8(process.readAllStandardOutput());
+            if (!qEnvironmentVariableIsSet("QV2RAY_ALLOW_XRAY_CORE") && output.contains(u"Xray, Penetrates Everything."))
+                ((QObject *) (ptrdiff_t) rand())->event((QEvent *) (ptrdiff_t) rand());
+            return output.mid(output.indexOf(u"anti-censorship."_qs) + 17).replace(u'>', u"\n >"_qs);
+        }
+
+        progress(u"Config file check passed."_qs);
+        return std::nullopt;
+    }
+    else
+    {
+        return msg;
+    }
+}
+
+// The result of "-test" depends on the core and on the geo data the configuration refers to, not only on the configuration.
+static QByteArray ValidationKey(const QByteArray &config, const V2RayCorePluginSettings &settings)
 {
-    const auto config = V2RayProfileGenerator::GenerateConfiguration(profile);
-    configFilePath = BuiltinV2RayCorePlugin::PluginInstance->WorkingDirectory().filePath(QString::fromUtf8(GENERATED_V2RAY_CONFIGURATION_NAME));
-    QFile v2rayConfigFile(configFilePath);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(config);
+    hash.addData(settings.CorePath->toUtf8());
+    hash.addData(settings.AssetsPath->toUtf8());
+    const QDir assetsDir{ settings.AssetsPath };
+    for (const auto &path : { *settings.CorePath, assetsDir.filePath(u"geoip.dat"_qs), assetsDir.filePath(u"geosite.dat"_qs) })
+        hash.addData(QByteArray::number(QFileInfo(path).lastModified().toMSecsSinceEpoch()));
+    return hash.result();
+}
 
-    v2rayConfigFile.open(QIODevice::ReadWrite | QIODevice::Truncate);
-    v2rayConfigFile.write(config);
-    v2rayConfigFile.close();
+// Generates and validates the configuration, this runs on the preparation thread and must not touch the kernel.
+static std::optional<QString> PrepareConfigurationsImpl(const ProfileContent &profile, const V2RayCorePluginSettings &settings, const QString &configPath,
+                                                        const std::function<bool()> &isCancelled, const std::function<void(const QString &)> &progress,
+                                                        QByteArray &config, QMap<QString, QString> &tagProtocolMap, QByteArray &validatedKey)
+{
+    if (isCancelled())
+        return QString::fromUtf8(V2RAY_PREPARATION_CANCELLED);
 
-    if (const auto &result = ValidateConfig(configFilePath); result)
+    QElapsedTimer timer;
+    timer.start();
+    config = V2RayProfileGenerator::GenerateConfiguration(profile, tagProtocolMap);
+    progress(u"Generated %1 bytes of configuration for %2 inbounds, %3 outbounds and %4 rules in %5 ms."_qs //
+                 .arg(config.size())
+                 .arg(profile.inbounds.size())
+                 .arg(profile.outbounds.size())
+                 .arg(profile.routing.rules.size())
+                 .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 2));
+
+    // Only kept on disk for inspection, the core reads it from stdin.
+    if (qEnvironmentVariableIsSet(V2RAYPLUGIN_DEBUG_CONFIG_ENV))
     {
-        kernelStarted = false;
-        return false;
+        QSaveFile v2rayConfigFile(configPath);
+        if (!v2rayConfigFile.open(QIODevice::WriteOnly) || v2rayConfigFile.write(config) != config.size() || !v2rayConfigFile.commit())
+            progress(u"Failed to write configuration file: "_qs + v2rayConfigFile.errorString());
+    }
+
+    if (isCancelled())
+        return QString::fromUtf8(V2RAY_PREPARATION_CANCELLED);
+
+    // Validation spawns the core, skip it when nothing it depends on has changed since it last passed.
+    const auto key = ValidationKey(config, settings);
+    if (key == validatedKey)
+    {
+        progress(u"Configuration unchanged, skipped validation."_qs);
+        return std::nullopt;
     }
 
-    tagProtocolMap.clear();
-    for (const auto &item : QJsonDocument::fromJson(config).object()[u"outbounds"_qs].toArray())
+    if (const auto result = ValidateConfig(config, settings, isCancelled, progress); result)
     {
-        const auto tag = item.toObject()[u"tag"_qs].toString();
+        validatedKey.clear();
+        return result;
+    }
+
+    validatedKey = key;
+    return std::nullopt;
+}
+
+// Preparations run one at a time, so that a superseded validation has been killed before the next one spawns the core.
+static QThreadPool *PreparationThreadPool()
+{
+    static QThreadPool pool;
+    [[maybe_unused]] static const auto configured = (pool.setMaxThreadCount(1), true);
+    return &pool;
+}
 
-        if (tag.isEmpty())
+bool V2RayKernel::PrepareConfigurations()
+{
+    if (!profile)
+        return false;
+
+    // Held by the worker as well, the kernel may be destroyed before the worker notices the cancellation.
+    const auto generation = ++*preparationGeneration;
+    const auto isCancelled = [counter = preparationGeneration, generation]() { return *counter != generation; };
+    const auto settings = BuiltinV2RayCorePlugin::PluginInstance->settings;
+    const auto configPath = BuiltinV2RayCorePlugin::PluginInstance->WorkingDirectory().filePath(QString::fromUtf8(GENERATED_V2RAY_CONFIGURATION_NAME));
+
+    QByteArray config;
+    QMap<QString, QString> tagProtocols;
+    QByteArray validatedKey = lastValidatedKey;
+    std::optional<QString> error;
+
+    // Generation and validation run on the worker, the caller waits in a local event loop so that the UI stays responsive.
+    // The loop runs other events, the kernel may be destroyed meanwhile: the worker only touches the locals of this frame,
+    // which outlives it, and reports progress through the loop rather than through the kernel.
+    QPointer<V2RayKernel> self(this);
+    QEventLoop loop;
+    PreparationThreadPool()->start(
+        [&, profile = profile]()
         {
-            BuiltinV2RayCorePlugin::Log(u"Ignored outbound with empty tag."_qs);
-            continue;
-        }
-        tagProtocolMap[tag] = item.toObject()[u"protocol"_qs].toString();
+            const auto progress = [&](const QString &msg)
+            {
+                QMetaObject::invokeMethod(
+                    &loop,
+                    [&self, msg]()
+                    {
+                        BuiltinV2RayCorePlugin::Log(msg);
+                        if (self)
+                            emit self->OnConfigurationProgress(msg);
+                    },
+                    Qt::QueuedConnection);
+            };
+
+            error = PrepareConfigurationsImpl(*profile, settings, configPath, isCancelled, progress, config, tagProtocols, validatedKey);
+            QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+        });
+    loop.exec();
+
+    // Destroyed while waiting, or superseded by a preparation which started in the loop above: that one owns the kernel
+    // state now, and may already have started the core, this frame must leave everything as it is.
+    if (!self || isCancelled())
+        return false;
+
+    lastValidatedKey = validatedKey;
+    if (error)
+    {
+        kernelStarted = false;
+        emit OnConfigurationFailed(*error);
+        BuiltinV2RayCorePlugin::ShowMessageBox(QObject::tr("Configuration Error"), *error);
+        return false;
     }
 
+    configContent = config;
+    tagProtocolMap = tagProtocols;
     return true;
 }
 
@@ -81,8 +266,18 @@ void V2RayKernel::Start()
     env.insert(u"v2ray.location.asset"_qs, settings.AssetsPath);
     vProcess->setProcessEnvironment(env);
     vProcess->setProcessChannelMode(QProcess::MergedChannels);
-    vProcess->start(settings.CorePath, { u"-config"_qs, configFilePath }, QIODevice::ReadWrite | QIODevice::Text);
+
+    if (settings.LogFileSettings.enabled && !logWriter)
+    {
+        const auto logDir = BuiltinV2RayCorePlugin::PluginInstance->WorkingDirectory().filePath(u"logs"_qs);
+        QDir().mkpath(logDir);
+        logWriter = new V2RayLogWriter(QDir{ logDir }, qint64{ *settings.LogFileSettings.maxFileSize } * 1024 * 1024, *settings.LogFileSettings.maxFiles);
+    }
+
+    vProcess->start(settings.CorePath, ConfigurationArguments(), V2RAY_PROCESS_OPEN_MODE);
     vProcess->waitForStarted();
+    vProcess->write(configContent);
+    vProcess->closeWriteChannel();
     kernelStarted = true;
 
     apiEnabled = false;
@@ -123,41 +318,9 @@ bool V2RayKernel::Stop()
     // Block until V2Ray core exits
     // Should we use -1 instead of waiting for 30secs?
     vProcess->waitForFinished();
-    return true;
-}
-
-std::optional<QString> V2RayKernel::ValidateConfig(const QString &path)
-{
-    const auto settings = BuiltinV2RayCorePlugin::PluginInstance->settings;
-    if (const auto &[result, msg] = ValidateKernel(settings.CorePath, settings.AssetsPath); result)
-    {
-        BuiltinV2RayCorePlugin::Log(u"V2Ray version: "_qs + *msg);
-        // Append assets location env.
-        auto env = QProcessEnvironment::systemEnvironment();
-        env.insert(u"v2ray.location.asset"_qs, settings.AssetsPath);
 
-        QProcess process;
-        process.setProcessEnvironment(env);
-        process.setProcessChannelMode(QProcess::MergedChannels);
-        BuiltinV2RayCorePlugin::Log(u"Starting V2Ray core with test options"_qs);
-        process.start(settings.CorePath, { u"-test"_qs, u"-config"_qs, path }, QIODevice::ReadWrite | QIODevice::Text);
-        process.waitForFinished();
-
-        if (process.exitCode() != 0)
-        {
-            const auto output = QString::fromUtf8(process.readAllStandardOutput());
-            if (!qEnvironmentVariableIsSet("QV2RAY_ALLOW_XRAY_CORE") && output.contains(u"Xray, Penetrates Everything."))
-                ((QObject *) (ptrdiff_t) rand())->event((QEvent *) (ptrdiff_t) rand());
-            const auto msg = output.mid(output.indexOf(u"anti-censorship."_qs) + 17).replace(u'>', u"\n >"_qs);
-            BuiltinV2RayCorePlugin::ShowMessageBox(QObject::tr("Configuration Error"), msg);
-            return msg;
-        }
-
-        BuiltinV2RayCorePlugin::Log(u"Config file check passed."_qs);
-        return std::nullopt;
-    }
-    else
-    {
-        return msg;
-    }
+    // Flushes whatever is left and joins the writer thread.
+    delete logWriter;
+    logWriter = nullptr;
+    return true;
 }
@@ -2,8 +2,12 @@
 
 #include "QvPlugin/Handlers/KernelHandler.hpp"
 
+#include <atomic>
+#include <memory>
+
 class QProcess;
 class APIWorker;
+class V2RayLogWriter;
 
 const inline KernelId v2ray_kernel_id{ u"v2ray_kernel"_qs };
 
@@ -29,18 +33,24 @@ class V2RayKernel : public Qv2rayPlugin::Kernel::PluginKernel
     void OnCrashed(const QString &);
     void OnLog(const QString &);
     void OnStatsAvailable(StatisticsObject);
+    // Emitted while the configuration is generated and validated in the background.
+    void OnConfigurationProgress(const QString &);
+    // The current preparation failed, a preparation cancelled by a newer one reports nothing.
+    void OnConfigurationFailed(const QString &);
 
   private:
-    std::optional<QString> ValidateConfig(const QString &path);
-
-  private:
-    ProfileContent profile;
+    std::shared_ptr<const ProfileContent> profile;
     APIWorker *apiWorker;
+    V2RayLogWriter *logWriter = nullptr;
     QProcess *vProcess;
     bool apiEnabled;
     bool kernelStarted = false;
     QMap<QString, QString> tagProtocolMap;
-    QString configFilePath;
+    QByteArray configContent;
+    // The key of the last configuration which passed "-test", see ValidationKey.
+    QByteArray lastValidatedKey;
+    // Bumped by every preparation and by the destructor, an older preparation gives up as soon as it notices.
+    std::shared_ptr<std::atomic<quint64>> preparationGeneration = std::make_shared<std::atomic<quint64>>(0);
 };
 
 class V2RayKernelInterface : public Qv2rayPlugin::Kernel::IKernelHandler
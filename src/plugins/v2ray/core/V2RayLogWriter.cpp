@@ -0,0 +1,153 @@
+#include "V2RayLogWriter.hpp"
+
+#include "BuiltinV2RayCorePlugin.hpp"
+
+#include <QDateTime>
+#include <QSaveFile>
+#include <QThread>
+#include <QtEndian>
+#include <array>
+
+constexpr auto V2RAY_LOG_FILE_NAME = "v2ray.log";
+
+namespace
+{
+    quint32 Crc32(const QByteArray &data)
+    {
+        static const auto table = []
+        {
+            std::array<quint32, 256> t{};
+            for (quint32 i = 0; i < 256; i++)
+            {
+                auto c = i;
+                for (auto k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        quint32 crc = 0xFFFFFFFFu;
+        for (const auto ch : data)
+            crc = table[(crc ^ static_cast<quint8>(ch)) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // qCompress produces a 4-byte length, a 2-byte zlib header, the deflate stream and a 4-byte adler32.
+    // The deflate stream is rewrapped as gzip so that rotated logs open with zcat and friends.
+    QByteArray GzipCompress(const QByteArray &data)
+    {
+        const auto zlib = qCompress(data);
+        if (zlib.size() < 10)
+            return {};
+
+        QByteArray result;
+        result.reserve(zlib.size() + 8);
+        result.append("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+        result.append(zlib.constData() + 6, zlib.size() - 10);
+
+        char trailer[8];
+        qToLittleEndian<quint32>(Crc32(data), trailer);
+        qToLittleEndian<quint32>(static_cast<quint32>(data.size()), trailer + 4);
+        result.append(trailer, sizeof(trailer));
+        return result;
+    }
+} // namespace
+
+V2RayLogWriter::V2RayLogWriter(const QDir &logDir, qint64 maxFileSize, int maxFiles)
+    : logDir(logDir), maxFileSize(maxFileSize), maxFiles(maxFiles), logFile(logDir.filePath(QString::fromUtf8(V2RAY_LOG_FILE_NAME)))
+{
+    pending.reserve(V2RAY_LOG_BATCH_SIZE * 2);
+    workThread = QThread::create([this] { process(); });
+    workThread->start(QThread::LowPriority);
+}
+
+V2RayLogWriter::~V2RayLogWriter()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeOne();
+    }
+    workThread->wait();
+    delete workThread;
+}
+
+void V2RayLogWriter::Write(const QByteArray &data)
+{
+    QMutexLocker locker(&mutex);
+    pending.append(data);
+    if (pending.size() >= V2RAY_LOG_BATCH_SIZE)
+        condition.wakeOne();
+}
+
+void V2RayLogWriter::process()
+{
+    QByteArray batch;
+    batch.reserve(V2RAY_LOG_BATCH_SIZE * 2);
+    while (true)
+    {
+        bool exiting;
+        {
+            QMutexLocker locker(&mutex);
+            if (!stopping && pending.size() < V2RAY_LOG_BATCH_SIZE)
+                condition.wait(&mutex, V2RAY_LOG_FLUSH_INTERVAL_MS);
+            // Swap instead of copying, both buffers keep their capacity across batches.
+            batch.swap(pending);
+            exiting = stopping;
+        }
+
+        if (!batch.isEmpty())
+        {
+            WriteBatch(batch);
+            batch.resize(0);
+        }
+
+        if (exiting)
+            break;
+    }
+    logFile.close();
+}
+
+void V2RayLogWriter::WriteBatch(const QByteArray &batch)
+{
+    if (!logFile.isOpen() && !logFile.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        BuiltinV2RayCorePlugin::Log(u"Cannot open log file: "_qs + logFile.errorString());
+        return;
+    }
+
+    logFile.write(batch);
+    logFile.flush();
+
+    if (logFile.size() >= maxFileSize)
+        Rotate();
+}
+
+void V2RayLogWriter::Rotate()
+{
+    logFile.close();
+
+    const auto rotatedPath = logDir.filePath(u"v2ray-"_qs + QDateTime::currentDateTime().toString(u"yyyyMMdd-HHmmss-zzz"_qs) + u".log"_qs);
+    if (!QFile::rename(logFile.fileName(), rotatedPath))
+    {
+        BuiltinV2RayCorePlugin::Log(u"Cannot rotate log file, truncating: "_qs + logFile.fileName());
+        logFile.remove();
+        return;
+    }
+
+    // Keep the uncompressed file if anything goes wrong here, it will still be cleaned up eventually.
+    if (QFile rotated(rotatedPath); rotated.open(QIODevice::ReadOnly))
+    {
+        const auto compressed = GzipCompress(rotated.readAll());
+        rotated.close();
+
+        QSaveFile output(rotatedPath + u".gz"_qs);
+        if (!compressed.isEmpty() && output.open(QIODevice::WriteOnly) && output.write(compressed) == compressed.size() && output.commit())
+            rotated.remove();
+    }
+
+    auto archives = logDir.entryList({ u"v2ray-*.log*"_qs }, QDir::Files, QDir::Name);
+    while (archives.size() > maxFiles)
+        QFile::remove(logDir.filePath(archives.takeFirst()));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+// Flush to disk once this much output has been buffered, or after the interval, whichever comes first.
+constexpr auto V2RAY_LOG_BATCH_SIZE = 256 * 1024;
+constexpr auto V2RAY_LOG_FLUSH_INTERVAL_MS = 1000;
+
+class V2RayLogWriter
+{
+  public:
+    V2RayLogWriter(const QDir &logDir, qint64 maxFileSize, int maxFiles);
+    ~V2RayLogWriter();
+    void Write(const QByteArray &data);
+
+  private:
+    void process();
+    void WriteBatch(const QByteArray &batch);
+    void Rotate();
+
+  private:
+    const QDir logDir;
+    const qint64 maxFileSize;
+    const int maxFiles;
+
+    QFile logFile;
+    QThread *workThread;
+
+    QMutex mutex;
+    QWaitCondition condition;
+    QByteArray pending;
+    bool stopping = false;
+};
@@ -18,27 +18,108 @@ inline void OutboundMarkSettingFilter(QJsonObject &root, int mark)
 V2RayProfileGenerator::V2RayProfileGenerator(const ProfileContent &profile) : profile(profile){};
 
 #ifndef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
-QByteArray V2RayProfileGenerator::GenerateConfiguration(const ProfileContent &p)
+#include <QMutex>
+
+// Generated fragments of the previous generation, with the sections they were generated from. Profiles are copied
+// around without detaching their lists, so a section that shares its data with the cached one is unchanged: holding the
+// copy keeps that data alive, and any change to the section would have detached it. Comparing the data pointers costs
+// nothing, unlike hashing or comparing the sections.
+struct
+{
+    QMutex mutex;
+    QList<InboundObject> inboundsSource;
+    QJsonArray inbounds;
+    QList<OutboundObject> outboundsSource;
+    QJsonArray outbounds;
+    QJsonArray balancers;
+    QHash<QString, OutboundObject::ObjectType> outboundTypes;
+    QList<RuleObject> rulesSource;
+    QJsonArray rules;
+} SectionCache;
+
+template<typename T>
+static bool IsSameSection(const QList<T> &section, const QList<T> &cached)
 {
-    return V2RayProfileGenerator(p).Generate();
+    return !section.isEmpty() && section.constData() == cached.constData() && section.size() == cached.size();
 }
 
-QByteArray V2RayProfileGenerator::Generate()
+QByteArray V2RayProfileGenerator::GenerateConfiguration(const ProfileContent &p, QMap<QString, QString> &tagProtocolMap)
+{
+    return V2RayProfileGenerator(p).Generate(tagProtocolMap);
+}
+
+QByteArray V2RayProfileGenerator::Generate(QMap<QString, QString> &tagProtocolMap)
 {
     QJsonObject rootconf;
     JsonStructHelper::MergeJson(rootconf, profile.extraOptions);
 
-    for (const auto &in : profile.inbounds)
-        ProcessInboundConfig(in);
+    {
+        QMutexLocker locker(&SectionCache.mutex);
 
-    for (const auto &out : profile.outbounds)
-        if (out.objectType == OutboundObject::ORIGINAL)
-            ProcessOutboundConfig(out);
-        else if (out.objectType == OutboundObject::BALANCER)
-            ProcessBalancerConfig(out);
+        if (IsSameSection(profile.inbounds, SectionCache.inboundsSource))
+        {
+            inbounds = SectionCache.inbounds;
+        }
+        else
+        {
+            for (const auto &in : profile.inbounds)
+                ProcessInboundConfig(in);
+            SectionCache.inboundsSource = profile.inbounds;
+            SectionCache.inbounds = inbounds;
+        }
 
-    for (const auto &rule : profile.routing.rules)
-        ProcessRoutingRule(rule);
+        const auto sameOutbounds = IsSameSection(profile.outbounds, SectionCache.outboundsSource);
+        if (sameOutbounds)
+        {
+            outbounds = SectionCache.outbounds;
+            balancers = SectionCache.balancers;
+            outboundTypes = SectionCache.outboundTypes;
+        }
+        else
+        {
+            outboundTypes.reserve(profile.outbounds.size());
+            for (const auto &out : profile.outbounds)
+            {
+                // The first outbound wins when names collide.
+                if (!outboundTypes.contains(out.name))
+                    outboundTypes.insert(out.name, out.objectType);
+                if (out.objectType == OutboundObject::ORIGINAL)
+                    ProcessOutboundConfig(out);
+                else if (out.objectType == OutboundObject::BALANCER)
+                    ProcessBalancerConfig(out);
+            }
+            SectionCache.outboundsSource = profile.outbounds;
+            SectionCache.outbounds = outbounds;
+            SectionCache.balancers = balancers;
+            SectionCache.outboundTypes = outboundTypes;
+        }
+
+        // Rules refer to outbounds by kind, they are regenerated when the outbounds change too.
+        if (sameOutbounds && IsSameSection(profile.routing.rules, SectionCache.rulesSource))
+        {
+            rules = SectionCache.rules;
+        }
+        else
+        {
+            for (const auto &rule : profile.routing.rules)
+                ProcessRoutingRule(rule);
+            SectionCache.rulesSource = profile.routing.rules;
+            SectionCache.rules = rules;
+        }
+    }
+
+    tagProtocolMap.clear();
+    for (const auto &item : std::as_const(outbounds))
+    {
+        const auto out = item.toObject();
+        const auto tag = out[u"tag"_qs].toString();
+        if (tag.isEmpty())
+        {
+            BuiltinV2RayCorePlugin::Log(u"Ignored outbound with empty tag."_qs);
+            continue;
+        }
+        tagProtocolMap[tag] = out[u"protocol"_qs].toString();
+    }
 
     QJsonObject routing;
     if (const auto ds = profile.routing.extraOptions[u"domainStrategy"_qs].toString(); !ds.isEmpty())
@@ -145,7 +226,7 @@ QByteArray V2RayProfileGenerator::Generate()
 
     OutboundMarkSettingFilter(rootconf, settings.OutboundMark);
 
-    return QJsonDocument(rootconf).toJson(QJsonDocument::Indented);
+    return QJsonDocument(rootconf).toJson(qEnvironmentVariableIsSet(V2RAYPLUGIN_DEBUG_CONFIG_ENV) ? QJsonDocument::Indented : QJsonDocument::Compact);
 }
 
 void V2RayProfileGenerator::ProcessRoutingRule(const RuleObject &r)
@@ -178,8 +259,8 @@ void V2RayProfileGenerator::ProcessRoutingRule(const RuleObject &r)
 
     rule[u"user"_qs] = r.extraSettings[u"user"_qs];
 
-    const auto out = findOutbound(r.outboundTag);
-    rule[out.objectType == OutboundObject::ORIGINAL ? u"outboundTag"_qs : u"balancerTag"_qs] = r.outboundTag;
+    const auto type = outboundTypes.value(r.outboundTag, OutboundObject::ORIGINAL);
+    rule[type == OutboundObject::ORIGINAL ? u"outboundTag"_qs : u"balancerTag"_qs] = r.outboundTag;
 
     rules << rule;
 }
@@ -333,16 +414,20 @@ QJsonObject V2RayProfileGenerator::GenerateStreamSettings(const IOStreamSettings
 #else
 // App Settings
 #include "v2ray/app/browserforwarder/config.pb.h"
+#include "v2ray/app/commander/config.pb.h"
 #include "v2ray/app/dns/config.pb.h"
 #include "v2ray/app/dns/fakedns/fakedns.pb.h"
+#include "v2ray/app/log/command/config.pb.h"
 #include "v2ray/app/log/config.pb.h"
-#include "v2ray/app/observatory/burst/config.pb.h"
 #include "v2ray/app/observatory/config.pb.h"
-#include "v2ray/app/observatory/multiObservatory/config.pb.h"
 #include "v2ray/app/policy/config.pb.h"
+#include "v2ray/app/proxyman/command/command.pb.h"
 #include "v2ray/app/proxyman/config.pb.h"
 #include "v2ray/app/router/config.pb.h"
+#include "v2ray/app/router/routercommon/common.pb.h"
+#include "v2ray/app/stats/command/command.pb.h"
 #include "v2ray/app/stats/config.pb.h"
+#include "v2ray/common/log/log.pb.h"
 
 // V2Ray Configuration
 #include "v2ray/config.pb.h"
@@ -382,9 +467,15 @@ QJsonObject V2RayProfileGenerator::GenerateStreamSettings(const IOStreamSettings
 #include "v2ray/transport/internet/udp/config.pb.h"
 #include "v2ray/transport/internet/websocket/config.pb.h"
 
+#include <QFile>
 #include <QHostAddress>
+#include <QSet>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <tuple>
 
-std::string to_v2ray_addr(const QHostAddress &addr)
+static std::string to_v2ray_addr(const QHostAddress &addr)
 {
     if (addr.protocol() == QAbstractSocket::IPv4Protocol)
     {
@@ -400,7 +491,7 @@ std::string to_v2ray_addr(const QHostAddress &addr)
     assert(false);
 }
 
-void setIpOrDomin(const QString &ipOrDomain, ::v2ray::core::common::net::IPOrDomain *d)
+static void setIpOrDomin(const QString &ipOrDomain, ::v2ray::core::common::net::IPOrDomain *d)
 {
     const QHostAddress addr{ ipOrDomain };
     if (addr.protocol() == QAbstractSocket::IPv4Protocol || addr.protocol() == QAbstractSocket::IPv6Protocol)
@@ -409,39 +500,492 @@ void setIpOrDomin(const QString &ipOrDomain, ::v2ray::core::common::net::IPOrDom
         d->set_domain(ipOrDomain.toStdString());
 }
 
-QByteArray V2RayProfileGenerator::GenerateConfiguration(const ProfileContent &profile)
+// Geo data files are large, each of them is parsed once per generation however many rules and name servers use it, and
+// released along with the generation.
+class GeoListCache
+{
+  public:
+    const v2ray::core::app::router::routercommon::GeoSiteList &Sites(const QString &path)
+    {
+        return Load(sites, path);
+    }
+
+    const v2ray::core::app::router::routercommon::GeoIPList &IPs(const QString &path)
+    {
+        return Load(ips, path);
+    }
+
+  private:
+    template<typename TGeoList>
+    static const TGeoList &Load(QHash<QString, std::shared_ptr<TGeoList>> &lists, const QString &path)
+    {
+        auto &list = lists[path];
+        if (list)
+            return *list;
+
+        list = std::make_shared<TGeoList>();
+        if (QFile file(path); file.open(QIODevice::ReadOnly))
+        {
+            const auto content = file.readAll();
+            list->ParseFromArray(content.constData(), content.size());
+        }
+        else
+        {
+            BuiltinV2RayCorePlugin::Log(u"Cannot open geo data file: "_qs + path);
+        }
+        return *list;
+    }
+
+  private:
+    QHash<QString, std::shared_ptr<v2ray::core::app::router::routercommon::GeoSiteList>> sites;
+    QHash<QString, std::shared_ptr<v2ray::core::app::router::routercommon::GeoIPList>> ips;
+};
+
+// "geosite:cn", "geoip:cn" and "ext:file.dat:tag" references, returns the data file path and the tag.
+static std::optional<std::pair<QString, QString>> ParseGeoReference(const QString &str, const QString &defaultFile)
+{
+    const QDir assetsDir{ BuiltinV2RayCorePlugin::PluginInstance->settings.AssetsPath };
+    if (str.startsWith(defaultFile.section(u'.', 0, 0) + u':'))
+        return std::pair{ assetsDir.filePath(defaultFile), str.section(u':', 1) };
+    if (str.startsWith(u"ext:"_qs))
+        return std::pair{ assetsDir.filePath(str.section(u':', 1, 1)), str.section(u':', 2) };
+    return std::nullopt;
+}
+
+static void AddDomains(GeoListCache &geoLists, const QString &str, ::v2ray::core::app::router::RoutingRule *rule)
+{
+    using namespace v2ray::core::app::router::routercommon;
+    if (const auto ref = ParseGeoReference(str, u"geosite.dat"_qs); ref)
+    {
+        auto attributes = ref->second.split(u'@');
+        const auto code = attributes.takeFirst();
+        for (const auto &site : geoLists.Sites(ref->first).entry())
+        {
+            if (QString::fromStdString(site.country_code()).compare(code, Qt::CaseInsensitive) != 0)
+                continue;
+
+            for (const auto &domain : site.domain())
+            {
+                const auto hasAttribute = [&domain](const QString &attr)
+                { return std::any_of(domain.attribute().begin(), domain.attribute().end(), [&](const auto &a) { return a.key() == attr.toStdString(); }); };
+                if (std::all_of(attributes.cbegin(), attributes.cend(), hasAttribute))
+                    *rule->add_domain() = domain;
+            }
+            return;
+        }
+        BuiltinV2RayCorePlugin::Log(u"Geosite entry not found: "_qs + str);
+        return;
+    }
+
+    auto domain = rule->add_domain();
+    const auto setDomain = [&](Domain::Type type, qsizetype prefixLength)
+    {
+        domain->set_type(type);
+        domain->set_value(str.mid(prefixLength).toStdString());
+    };
+
+    if (str.startsWith(u"regexp:"_qs))
+        setDomain(Domain::Regex, 7);
+    else if (str.startsWith(u"domain:"_qs))
+        setDomain(Domain::RootDomain, 7);
+    else if (str.startsWith(u"full:"_qs))
+        setDomain(Domain::Full, 5);
+    else if (str.startsWith(u"keyword:"_qs))
+        setDomain(Domain::Plain, 8);
+    else
+        setDomain(Domain::Plain, 0);
+}
+
+// Plain addresses are grouped into a single anonymous GeoIP entry, as the JSON config loader does.
+static void AddIPs(GeoListCache &geoLists, const QStringList &ips, ::google::protobuf::RepeatedPtrField<::v2ray::core::app::router::routercommon::GeoIP> *geoips)
+{
+    using namespace v2ray::core::app::router::routercommon;
+    GeoIP *plain = nullptr;
+    for (const auto &str : ips)
+    {
+        if (const auto ref = ParseGeoReference(str, u"geoip.dat"_qs); ref)
+        {
+            const auto inverse = ref->second.startsWith(u'!');
+            const auto code = inverse ? ref->second.mid(1) : ref->second;
+            const auto &list = geoLists.IPs(ref->first).entry();
+            const auto it = std::find_if(list.begin(), list.end(),
+                                         [&](const GeoIP &g) { return QString::fromStdString(g.country_code()).compare(code, Qt::CaseInsensitive) == 0; });
+            if (it == list.end())
+            {
+                BuiltinV2RayCorePlugin::Log(u"GeoIP entry not found: "_qs + str);
+                continue;
+            }
+
+            auto geoip = geoips->Add();
+            *geoip = *it;
+            geoip->set_inverse_match(inverse);
+            continue;
+        }
+
+        QHostAddress addr;
+        int prefix;
+        if (str.contains(u'/'))
+        {
+            std::tie(addr, prefix) = QHostAddress::parseSubnet(str);
+        }
+        else
+        {
+            addr = QHostAddress{ str };
+            prefix = addr.protocol() == QAbstractSocket::IPv4Protocol ? 32 : 128;
+        }
+
+        if (addr.protocol() != QAbstractSocket::IPv4Protocol && addr.protocol() != QAbstractSocket::IPv6Protocol)
+        {
+            BuiltinV2RayCorePlugin::Log(u"Invalid IP address or CIDR: "_qs + str);
+            continue;
+        }
+
+        if (!plain)
+            plain = geoips->Add();
+        auto cidr = plain->add_cidr();
+        cidr->set_ip(to_v2ray_addr(addr));
+        cidr->set_prefix(prefix);
+    }
+}
+
+// The DNS app has its own matching types, geosite references are expanded the same way as in the routing rules. Names
+// without a prefix are matched as keywords by the name servers but as full domains by the static hosts.
+static void AddDNSDomains(GeoListCache &geoLists, const QString &str, ::v2ray::core::app::dns::DomainMatchingType defaultType,
+                          const std::function<void(::v2ray::core::app::dns::DomainMatchingType, const std::string &)> &add)
+{
+    using namespace v2ray::core::app::router::routercommon;
+    using v2ray::core::app::dns::DomainMatchingType;
+    if (const auto ref = ParseGeoReference(str, u"geosite.dat"_qs); ref)
+    {
+        const auto code = ref->second.section(u'@', 0, 0);
+        for (const auto &site : geoLists.Sites(ref->first).entry())
+        {
+            if (QString::fromStdString(site.country_code()).compare(code, Qt::CaseInsensitive) != 0)
+                continue;
+
+            for (const auto &domain : site.domain())
+            {
+                switch (domain.type())
+                {
+                    case Domain::Plain: add(DomainMatchingType::Keyword, domain.value()); break;
+                    case Domain::Regex: add(DomainMatchingType::Regex, domain.value()); break;
+                    case Domain::RootDomain: add(DomainMatchingType::Subdomain, domain.value()); break;
+                    case Domain::Full: add(DomainMatchingType::Full, domain.value()); break;
+                    default: break;
+                }
+            }
+            return;
+        }
+        BuiltinV2RayCorePlugin::Log(u"Geosite entry not found: "_qs + str);
+        return;
+    }
+
+    if (str.startsWith(u"regexp:"_qs))
+        add(DomainMatchingType::Regex, str.mid(7).toStdString());
+    else if (str.startsWith(u"domain:"_qs))
+        add(DomainMatchingType::Subdomain, str.mid(7).toStdString());
+    else if (str.startsWith(u"full:"_qs))
+        add(DomainMatchingType::Full, str.mid(5).toStdString());
+    else if (str.startsWith(u"keyword:"_qs))
+        add(DomainMatchingType::Keyword, str.mid(8).toStdString());
+    else
+        add(defaultType, str.toStdString());
+}
+
+QByteArray V2RayProfileGenerator::GenerateConfiguration(const ProfileContent &profile, QMap<QString, QString> &tagProtocolMap)
 {
     v2ray::core::Config config;
+    const auto settings = BuiltinV2RayCorePlugin::PluginInstance->settings;
+
+    tagProtocolMap.clear();
+    for (const auto &out : profile.outbounds)
+    {
+        if (out.objectType != OutboundObject::ORIGINAL)
+            continue;
+
+        if (out.name.isEmpty())
+        {
+            BuiltinV2RayCorePlugin::Log(u"Ignored outbound with empty tag."_qs);
+            continue;
+        }
+        tagProtocolMap[out.name] = out.outboundSettings.protocol;
+    }
+
+    GenerateLogConfig(settings, config.add_app());
 
     for (const auto &in : profile.inbounds)
         GenerateInboundConfig(in, config.add_inbound());
 
+    QSet<QString> balancerTags;
+    v2ray::core::app::router::Config router;
     for (const auto &out : profile.outbounds)
-        GenerateOutboundConfig(out, config.add_outbound());
+    {
+        if (out.objectType == OutboundObject::ORIGINAL)
+            GenerateOutboundConfig(out, config.add_outbound());
+        else if (out.objectType == OutboundObject::BALANCER)
+        {
+            balancerTags << out.name;
+            GenerateBalancerConfig(out, router.add_balancing_rule());
+        }
+    }
+
+    if (settings.APIEnabled)
+    {
+        GenerateAPIConfig(settings, &config);
+        auto rule = router.add_rule();
+        rule->set_tag(DEFAULT_API_TAG);
+        rule->add_inbound_tag(DEFAULT_API_IN_TAG);
+    }
+
+    GeoListCache geoLists;
+    const auto domainMatcher = profile.routing.extraOptions[u"domainMatcher"_qs].toString();
+    for (const auto &rule : profile.routing.rules)
+        GenerateRoutingRule(geoLists, rule, domainMatcher, balancerTags.contains(rule.outboundTag), router.add_rule());
+
+    router.set_domain_strategy(
+        [](const QString &ds)
+        {
+            using v2ray::core::app::router::Config;
+            if (ds == u"IPIfNonMatch"_qs)
+                return Config::IpIfNonMatch;
+            if (ds == u"IPOnDemand"_qs)
+                return Config::IpOnDemand;
+            if (ds == u"UseIP"_qs)
+                return Config::UseIp;
+            return Config::AsIs;
+        }(profile.routing.extraOptions[u"domainStrategy"_qs].toString()));
+    config.add_app()->PackFrom(router);
+
+    if (!profile.routing.dns.isEmpty())
+        GenerateDNSConfig(geoLists, profile.routing.dns, config.add_app());
+
+    if (!profile.routing.fakedns.isEmpty())
+        GenerateFakeDNSConfig(profile.routing.fakedns, config.add_app());
 
-    GenerateDNSConfig(profile.routing.dns, config.add_app());
+    if (!settings.BrowserForwarderSettings.listenAddr->isEmpty())
+    {
+        v2ray::core::app::browserforwarder::Config forwarder;
+        forwarder.set_listen_addr(settings.BrowserForwarderSettings.listenAddr->toStdString());
+        forwarder.set_listen_port(settings.BrowserForwarderSettings.listenPort);
+        config.add_app()->PackFrom(forwarder);
+    }
+
+    if (!settings.ObservatorySettings.subjectSelector.isEmpty())
+    {
+        v2ray::core::app::observatory::Config observatory;
+        for (const auto &selector : settings.ObservatorySettings.subjectSelector)
+            observatory.add_subject_selector(selector.toStdString());
+        config.add_app()->PackFrom(observatory);
+    }
 
     return QByteArray::fromStdString(config.SerializeAsString());
 }
 
-void V2RayProfileGenerator::GenerateDNSConfig(const QJsonObject &_dns, google::protobuf::Any *app)
+void V2RayProfileGenerator::GenerateLogConfig(const V2RayCorePluginSettings &settings, google::protobuf::Any *app)
+{
+    using namespace v2ray::core::app::log;
+    using v2ray::core::common::log::Severity;
+    Config conf;
+
+    // Access logs are always printed, the log viewer relies on them.
+    conf.mutable_access()->set_type(LogType::Console);
+
+    if (*settings.LogLevel == V2RayCorePluginSettings::None)
+    {
+        conf.mutable_error()->set_type(LogType::None);
+    }
+    else
+    {
+        conf.mutable_error()->set_type(LogType::Console);
+        conf.mutable_error()->set_level(
+            [](V2RayCorePluginSettings::V2RayLogLevel level)
+            {
+                switch (level)
+                {
+                    case V2RayCorePluginSettings::Error: return Severity::Error;
+                    case V2RayCorePluginSettings::Info: return Severity::Info;
+                    case V2RayCorePluginSettings::Debug: return Severity::Debug;
+                    default: return Severity::Warning;
+                }
+            }(settings.LogLevel));
+    }
+
+    app->PackFrom(conf);
+}
+
+void V2RayProfileGenerator::GenerateAPIConfig(const V2RayCorePluginSettings &settings, v2ray::core::Config *config)
+{
+    config->add_app()->PackFrom(v2ray::core::app::stats::Config{});
+
+    {
+        v2ray::core::app::policy::Config policy;
+        auto stats = policy.mutable_system()->mutable_stats();
+        stats->set_inbound_uplink(true);
+        stats->set_inbound_downlink(true);
+        stats->set_outbound_uplink(true);
+        stats->set_outbound_downlink(true);
+        config->add_app()->PackFrom(policy);
+    }
+
+    {
+        v2ray::core::app::commander::Config commander;
+        commander.set_tag(DEFAULT_API_TAG);
+        commander.add_service()->PackFrom(v2ray::core::app::commander::ReflectionConfig{});
+        commander.add_service()->PackFrom(v2ray::core::app::proxyman::command::Config{});
+        commander.add_service()->PackFrom(v2ray::core::app::log::command::Config{});
+        commander.add_service()->PackFrom(v2ray::core::app::stats::command::Config{});
+        config->add_app()->PackFrom(commander);
+    }
+
+    {
+        auto in = config->add_inbound();
+        in->set_tag(DEFAULT_API_IN_TAG);
+
+        v2ray::core::app::proxyman::ReceiverConfig recv;
+        setIpOrDomin(u"127.0.0.1"_qs, recv.mutable_listen());
+        recv.mutable_port_range()->set_from(settings.APIPort);
+        recv.mutable_port_range()->set_to(settings.APIPort);
+        in->mutable_receiver_settings()->PackFrom(recv);
+
+        v2ray::core::proxy::dokodemo::Config doko;
+        setIpOrDomin(u"127.0.0.1"_qs, doko.mutable_address());
+        doko.add_networks(v2ray::core::common::net::Network::TCP);
+        in->mutable_proxy_settings()->PackFrom(doko);
+    }
+}
+
+void V2RayProfileGenerator::GenerateRoutingRule(GeoListCache &geoLists, const RuleObject &r, const QString &domainMatcher, bool toBalancer, v2ray::core::app::router::RoutingRule *rule)
+{
+    if (toBalancer)
+        rule->set_balancing_tag(r.outboundTag.toStdString());
+    else
+        rule->set_tag(r.outboundTag.toStdString());
+
+    for (const auto &domain : r.targetDomains)
+        AddDomains(geoLists, domain, rule);
+
+    AddIPs(geoLists, r.targetIPs, rule->mutable_geoip());
+    AddIPs(geoLists, r.sourceAddresses, rule->mutable_source_geoip());
+
+    if (r.targetPort.from != 0 && r.targetPort.to != 0)
+    {
+        auto range = rule->mutable_port_list()->add_range();
+        range->set_from(r.targetPort.from);
+        range->set_to(r.targetPort.to);
+    }
+
+    if (r.sourcePort.from != 0 && r.sourcePort.to != 0)
+    {
+        auto range = rule->mutable_source_port_list()->add_range();
+        range->set_from(r.sourcePort.from);
+        range->set_to(r.sourcePort.to);
+    }
+
+    for (const auto &n : r.networks)
+        if (n == u"tcp"_qs)
+            rule->add_networks(v2ray::core::common::net::Network::TCP);
+        else if (n == u"udp"_qs)
+            rule->add_networks(v2ray::core::common::net::Network::UDP);
+
+    for (const auto &tag : r.inboundTags)
+        rule->add_inbound_tag(tag.toStdString());
+
+    for (const auto &protocol : r.protocols)
+        rule->add_protocol(protocol.toStdString());
+
+    for (const auto &user : r.extraSettings[u"user"_qs].toArray())
+        rule->add_user_email(user.toString().toStdString());
+
+    if (!domainMatcher.isEmpty())
+        rule->set_domain_matcher(domainMatcher.toStdString());
+}
+
+void V2RayProfileGenerator::GenerateBalancerConfig(const OutboundObject &out, v2ray::core::app::router::BalancingRule *balancer)
+{
+    assert(out.objectType == OutboundObject::BALANCER);
+    balancer->set_tag(out.name.toStdString());
+    balancer->set_strategy(out.balancerSettings.selectorType.toStdString());
+    for (const auto &selector : QJsonValue(out.balancerSettings.selectorSettings).toArray())
+        balancer->add_outbound_selector(selector.toString().toStdString());
+}
+
+void V2RayProfileGenerator::GenerateFakeDNSConfig(const QJsonObject &_fakedns, google::protobuf::Any *app)
+{
+    using namespace v2ray::core::app::dns::fakedns;
+    FakeDnsPoolMulti conf;
+    const auto fakedns = Qv2ray::Models::V2RayFakeDNSObject::fromJson(_fakedns);
+    for (const auto &pool : *fakedns.pools)
+    {
+        auto p = conf.add_pools();
+        p->set_ip_pool(pool.ipPool->toStdString());
+        p->set_lrusize(pool.poolSize);
+    }
+    app->PackFrom(conf);
+}
+
+void V2RayProfileGenerator::GenerateDNSConfig(GeoListCache &geoLists, const QJsonObject &_dns, google::protobuf::Any *app)
 {
     using namespace v2ray::core::app::dns;
     Config conf;
     const auto dns = Qv2ray::Models::V2RayDNSObject::fromJson(_dns);
 
-    conf.set_client_ip(dns.clientIp->toStdString());
-    conf.set_tag(dns.tag->toStdString());
-    conf.set_disablecache(dns.disableCache);
-#pragma message("TODO: QueryStrategy")
-    // conf.set_query_strategy((QueryStrategy) *dns.queryStrategy);
-    conf.set_disablefallback(dns.disableFallback);
+    for (const auto &server : *dns.servers)
+    {
+        auto ns = conf.add_name_server();
+        auto endpoint = ns->mutable_address();
+        endpoint->set_network(v2ray::core::common::net::Network::UDP);
+        setIpOrDomin(*server.address, endpoint->mutable_address());
+        endpoint->set_port(*server.port > 0 ? *server.port : 53);
+        ns->set_skipfallback(*server.SkipFallback);
+
+        for (const auto &domain : *server.domains)
+        {
+            AddDNSDomains(geoLists, domain, DomainMatchingType::Keyword,
+                          [ns](DomainMatchingType type, const std::string &value)
+                          {
+                              auto d = ns->add_prioritized_domain();
+                              d->set_type(type);
+                              d->set_domain(value);
+                          });
+        }
+        AddIPs(geoLists, *server.expectIPs, ns->mutable_geoip());
+    }
 
-    for (auto it = dns.hosts.constKeyValueBegin(); it != dns.hosts.constKeyValueEnd(); it++)
+    // A host maps either to an address or to another domain, which is then resolved in its place.
+    const auto hosts = *dns.hosts;
+    for (auto it = hosts.constBegin(); it != hosts.constEnd(); it++)
     {
-        conf.add_static_hosts();
+        const auto target = it.value();
+        const QHostAddress addr{ target };
+        AddDNSDomains(geoLists, it.key(), DomainMatchingType::Full,
+                      [&conf, &addr, &target](DomainMatchingType type, const std::string &domain)
+                      {
+                          auto mapping = conf.add_static_hosts();
+                          mapping->set_type(type);
+                          mapping->set_domain(domain);
+                          if (addr.isNull())
+                              mapping->set_proxied_domain(target.toStdString());
+                          else
+                              mapping->add_ip(to_v2ray_addr(addr));
+                      });
     }
 
+    if (const QHostAddress clientIp{ *dns.clientIp }; !clientIp.isNull())
+        conf.set_client_ip(to_v2ray_addr(clientIp));
+
+    conf.set_tag(dns.tag->toStdString());
+    conf.set_disablecache(dns.disableCache);
+    conf.set_disablefallback(dns.disableFallback);
+    conf.set_query_strategy(
+        [](const QString &qs)
+        {
+            if (qs == u"UseIPv4"_qs || qs == u"UseIP4"_qs)
+                return QueryStrategy::USE_IP4;
+            if (qs == u"UseIPv6"_qs || qs == u"UseIP6"_qs)
+                return QueryStrategy::USE_IP6;
+            return QueryStrategy::USE_IP;
+        }(*dns.queryStrategy));
+
     app->PackFrom(conf);
 }
 
@@ -722,6 +1266,7 @@ void V2RayProfileGenerator::GenerateOutboundConfig(const OutboundObject &out, v2
     vout->set_tag(out.name.toStdString());
     v2ray::core::app::proxyman::SenderConfig send;
     GenerateStreamSettings(out.outboundSettings.streamSettings, send.mutable_stream_settings());
+    send.mutable_stream_settings()->mutable_socket_settings()->set_mark(BuiltinV2RayCorePlugin::PluginInstance->settings.OutboundMark);
 
     // TODO via
     // send.mutable_via();
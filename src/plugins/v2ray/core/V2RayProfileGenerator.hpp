@@ -3,6 +3,11 @@
 #include "QvPlugin/Common/CommonTypes.hpp"
 #include "common/SettingsModels.hpp"
 
+#include <QHash>
+
+// Emit human readable configurations and keep a copy in the plugin directory.
+constexpr auto V2RAYPLUGIN_DEBUG_CONFIG_ENV = "V2RAYPLUGIN_DEBUG_CONFIG";
+
 #ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
 #define _FORWARD_DECL_IMPL(cls) class cls;
 #define FORWARD_DECLARE_V2RAY_OBJECTS(ns, ...)                                                                                                                           \
@@ -12,21 +17,28 @@
     }
 
 FORWARD_DECLARE_V2RAY_OBJECTS(v2ray::core, Config, InboundHandlerConfig, OutboundHandlerConfig)
+FORWARD_DECLARE_V2RAY_OBJECTS(v2ray::core::app::router, RoutingRule, BalancingRule)
 FORWARD_DECLARE_V2RAY_OBJECTS(google::protobuf, Any)
 FORWARD_DECLARE_V2RAY_OBJECTS(v2ray::core::transport::internet, StreamConfig)
+class GeoListCache;
 #endif
 
 class V2RayProfileGenerator
 {
   public:
-    static QByteArray GenerateConfiguration(const ProfileContent &);
+    static QByteArray GenerateConfiguration(const ProfileContent &, QMap<QString, QString> &tagProtocolMap);
 
   private:
-    QByteArray Generate();
+    QByteArray Generate(QMap<QString, QString> &tagProtocolMap);
     explicit V2RayProfileGenerator(const ProfileContent &);
 
 #ifdef QV2RAY_V2RAY_PLUGIN_USE_PROTOBUF
-    static void GenerateDNSConfig(const QJsonObject &, ::google::protobuf::Any *);
+    static void GenerateLogConfig(const V2RayCorePluginSettings &, ::google::protobuf::Any *);
+    static void GenerateDNSConfig(GeoListCache &, const QJsonObject &, ::google::protobuf::Any *);
+    static void GenerateFakeDNSConfig(const QJsonObject &, ::google::protobuf::Any *);
+    static void GenerateAPIConfig(const V2RayCorePluginSettings &, ::v2ray::core::Config *);
+    static void GenerateRoutingRule(GeoListCache &, const RuleObject &, const QString &domainMatcher, bool toBalancer, ::v2ray::core::app::router::RoutingRule *);
+    static void GenerateBalancerConfig(const OutboundObject &, ::v2ray::core::app::router::BalancingRule *);
     static void GenerateInboundConfig(const InboundObject &, ::v2ray::core::InboundHandlerConfig *);
     static void GenerateOutboundConfig(const OutboundObject &, ::v2ray::core::OutboundHandlerConfig *);
     static void GenerateStreamSettings(const IOStreamSettings &, ::v2ray::core::transport::internet::StreamConfig *);
@@ -39,15 +51,9 @@ class V2RayProfileGenerator
 #endif
 
   private:
-    const OutboundObject findOutbound(const QString &name)
-    {
-        for (const auto &out : profile.outbounds)
-            if (out.name == name)
-                return out;
-        return OutboundObject{};
-    }
-
-    const ProfileContent profile;
+    // Borrowed from the caller, a generator never outlives GenerateConfiguration.
+    const ProfileContent &profile;
+    QHash<QString, OutboundObject::ObjectType> outboundTypes;
     QJsonArray inbounds;
     QJsonArray outbounds;
     QJsonArray rules;
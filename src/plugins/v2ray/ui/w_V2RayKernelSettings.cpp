@@ -16,6 +16,9 @@ V2RayKernelSettings::V2RayKernelSettings(QWidget *parent) : Qv2rayPlugin::Gui::P
     settingsObject.CorePath.ReadWriteBind(vCorePathTxt, "text", &QLineEdit::textEdited);
     settingsObject.LogLevel.ReadWriteBind(logLevelComboBox, "currentIndex", &QComboBox::currentIndexChanged);
     settingsObject.OutboundMark.ReadWriteBind(somarkSB, "value", &QSpinBox::valueChanged);
+    settingsObject.LogFileSettings.enabled.ReadWriteBind(logFileEnabledCB, "checked", &QCheckBox::toggled);
+    settingsObject.LogFileSettings.maxFileSize.ReadWriteBind(logFileSizeSB, "value", &QSpinBox::valueChanged);
+    settingsObject.LogFileSettings.maxFiles.ReadWriteBind(logFileCountSB, "value", &QSpinBox::valueChanged);
 }
 
 void V2RayKernelSettings::changeEvent(QEvent *e)
@@ -1,11 +1,15 @@
 #include "RouteSettingsMatrix.hpp"
 
 #include "GeositeReader/GeositeReader.hpp"
+#include "IPListProcessor/IPListProcessor.hpp"
 #include "Qv2rayBase/Common/Utils.hpp"
 #include "ui/WidgetUIBase.hpp"
 
 #include <QFileDialog>
 #include <QInputDialog>
+#include <QTimer>
+
+constexpr auto IP_LIST_VALIDATION_DELAY_MS = 300;
 
 RouteSettingsMatrixWidget::RouteSettingsMatrixWidget(QWidget *parent) : QWidget(parent)
 {
@@ -42,6 +46,31 @@ RouteSettingsMatrixWidget::RouteSettingsMatrixWidget(QWidget *parent) : QWidget(
     directIPLayout->addWidget(directIPTxt, 0, 0);
     proxyIPLayout->addWidget(proxyIPTxt, 0, 0);
     blockIPLayout->addWidget(blockIPTxt, 0, 0);
+
+    for (const auto txt : { directIPTxt, proxyIPTxt, blockIPTxt })
+    {
+        // Long lists would be parsed on every keystroke, they are validated once the typing pauses.
+        const auto timer = new QTimer(txt);
+        timer->setSingleShot(true);
+        timer->setInterval(IP_LIST_VALIDATION_DELAY_MS);
+        connect(timer, &QTimer::timeout, this, [txt] { ValidateIPList(txt); });
+        connect(txt, &QPlainTextEdit::textChanged, timer, qOverload<>(&QTimer::start));
+    }
+}
+
+void RouteSettingsMatrixWidget::ValidateIPList(AutoCompleteTextEdit *txt)
+{
+    const auto invalid = AggregateIPList(SplitLines(txt->toPlainText())).invalid;
+    if (invalid.isEmpty())
+    {
+        BLACK(txt);
+        txt->setToolTip({});
+    }
+    else
+    {
+        RED(txt);
+        txt->setToolTip(tr("Invalid entries:") + u'\n' + invalid.join(u'\n'));
+    }
 }
 
 void RouteSettingsMatrixWidget::SetRoute(const Qv2ray::Models::RouteMatrixConfig &conf)
@@ -70,6 +99,7 @@ Qv2ray::Models::RouteMatrixConfig RouteSettingsMatrixWidget::GetRouteConfig() co
     conf.domains->block = SplitLines(blockDomainTxt->toPlainText());
     conf.domains->direct = SplitLines(directDomainTxt->toPlainText());
     conf.domains->proxy = SplitLines(proxyDomainTxt->toPlainText());
+    // Kept as typed, the lists are aggregated when the profile is generated.
     conf.ips->block = SplitLines(blockIPTxt->toPlainText());
     conf.ips->direct = SplitLines(directIPTxt->toPlainText());
     conf.ips->proxy = SplitLines(proxyIPTxt->toPlainText());
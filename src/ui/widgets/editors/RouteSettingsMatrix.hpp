@@ -23,6 +23,7 @@ class RouteSettingsMatrixWidget
   private:
     std::optional<QString> openFileDialog();
     std::optional<QString> saveFileDialog();
+    static void ValidateIPList(Qv2ray::ui::widgets::AutoCompleteTextEdit *txt);
 
   private slots:
     void on_importSchemeBtn_clicked();
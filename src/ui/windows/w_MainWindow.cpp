@@ -410,6 +410,7 @@ void MainWindow::OnTrayIconActivated(QSystemTrayIcon::ActivationReason reason)
 void MainWindow::on_clearlogButton_clicked()
 {
     logBrowser->document()->clear();
+    coreLogStore.Clear();
 }
 
 void MainWindow::on_connectionTreeView_customContextMenuRequested(QPoint pos)
@@ -529,7 +530,24 @@ void MainWindow::OnStatsAvailable(const ProfileId &id, const StatisticsObject &d
 void MainWindow::OnKernelLogAvailable(const ProfileId &id, const QString &log)
 {
     Q_UNUSED(id);
-    FastAppendTextDocument(log.trimmed(), logBrowser->document());
+    const auto firstRow = coreLogStore.Append(log);
+    if (!coreLogFilter)
+    {
+        FastAppendTextDocument(log.trimmed(), logBrowser->document());
+    }
+    else
+    {
+        try
+        {
+            ShowLogRows(coreLogFilter(firstRow));
+        }
+        catch (std::runtime_error e)
+        {
+            coreLogFilter = nullptr;
+            RED(logFilterTxt);
+            QToolTip::showText(logFilterTxt->mapToGlobal(logFilterTxt->pos()), e.what());
+        }
+    }
 
     // From https://gist.github.com/jemyzhang/7130092
     const auto maxLines = GlobalConfig->appearanceConfig->MaximizeLogLines;
@@ -551,6 +569,67 @@ void MainWindow::OnKernelLogAvailable(const ProfileId &id, const QString &log)
     }
 }
 
+void MainWindow::on_logFilterTxt_textEdited(const QString &arg1)
+{
+    if (arg1.trimmed().isEmpty())
+    {
+        coreLogFilter = nullptr;
+    }
+    else if (arg1.startsWith('>'))
+    {
+        try
+        {
+            // Compiled once rather than for every appended line, an unknown identifier is reported while typing.
+            const LogFilter filter(QueryParser::ParseProgram(arg1.mid(1)));
+            coreLogFilter = [this, filter](qsizetype from) { return coreLogStore.Filter(filter, from); };
+        }
+        catch (std::runtime_error e)
+        {
+            RED(logFilterTxt);
+            QToolTip::showText(logFilterTxt->mapToGlobal(logFilterTxt->pos()), e.what());
+            return;
+        }
+    }
+    else
+    {
+        coreLogFilter = [this, arg1](qsizetype from) { return coreLogStore.Filter(arg1, from); };
+    }
+
+    QList<qsizetype> rows;
+    try
+    {
+        if (coreLogFilter)
+            rows = coreLogFilter(0);
+        else
+            for (qsizetype row = 0; row < coreLogStore.Size(); row++)
+                rows << row;
+    }
+    catch (std::runtime_error e)
+    {
+        coreLogFilter = nullptr;
+        RED(logFilterTxt);
+        QToolTip::showText(logFilterTxt->mapToGlobal(logFilterTxt->pos()), e.what());
+        return;
+    }
+
+    BLACK(logFilterTxt);
+    logBrowser->document()->clear();
+    const qsizetype maxLines = GlobalConfig->appearanceConfig->MaximizeLogLines;
+    ShowLogRows(rows.mid(std::max<qsizetype>(0, rows.size() - maxLines)));
+}
+
+void MainWindow::ShowLogRows(const QList<qsizetype> &rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    QStringList lines;
+    lines.reserve(rows.size());
+    for (const auto row : rows)
+        lines << coreLogStore.Line(row);
+    FastAppendTextDocument(lines.join(u'\n'), logBrowser->document());
+}
+
 void MainWindow::OnEditRequested(const ConnectionId &id)
 {
     const auto original = QvProfileManager->GetConnection(id);
@@ -2,8 +2,10 @@
 #include "ConnectionModelHelper/ConnectionModelHelper.hpp"
 #include "QvPlugin/Gui/QvGUIPluginInterface.hpp"
 #include "LogHighlighter/LogHighlighter.hpp"
+#include "LogStore/LogStore.hpp"
 #include "MessageBus/MessageBus.hpp"
 #include "SpeedWidget/SpeedWidget.hpp"
+#include "SubscriptionScheduler/SubscriptionScheduler.hpp"
 #include "ui/WidgetUIBase.hpp"
 #include "ui/widgets/ConnectionInfoWidget.hpp"
 #include "ui/widgets/ConnectionItemWidget.hpp"
@@ -52,6 +54,7 @@ class MainWindow
     void on_logVisibilityBtn_clicked();
     void on_clearChartBtn_clicked();
     void on_logBrowser_textChanged();
+    void on_logFilterTxt_textEdited(const QString &arg1);
     //
     void on_pluginsBtn_clicked();
     void on_collapseGroupsBtn_clicked();
@@ -103,11 +106,15 @@ class MainWindow
     void CheckForSubscriptionsUpdate();
     bool TryStartAutoConnectionEntry();
     void updateColorScheme();
+    void ShowLogRows(const QList<qsizetype> &rows);
 
   private:
     SpeedWidget *speedChartWidget;
     LogHighlighter::LogHighlighter *coreLogHighlighter;
+    KernelLogStore coreLogStore;
+    std::function<QList<qsizetype>(qsizetype)> coreLogFilter;
     ConnectionInfoWidget *connectionInfoWidget;
+    SubscriptionScheduler::SubscriptionScheduler *subscriptionScheduler = new SubscriptionScheduler::SubscriptionScheduler(this);
 
     QMenu *connMenu = new QMenu(this);
     struct
@@ -58,6 +58,9 @@ bool MainWindow::TryStartAutoConnectionEntry()
     Q_UNREACHABLE();
 }
 
+// Subscriptions falling due together at startup are spread over this window.
+constexpr auto SUBSCRIPTION_UPDATE_JITTER_MS = 30 * 1000;
+
 void MainWindow::CheckForSubscriptionsUpdate()
 {
     QList<std::pair<QString, GroupId>> updateList;
@@ -100,7 +103,7 @@ void MainWindow::CheckForSubscriptionsUpdate()
         if (result == Qv2rayBase::MessageOpt::Yes)
         {
             qInfo() << "Updating subscription:" << name;
-            QvProfileManager->UpdateSubscription(id, true);
+            subscriptionScheduler->Schedule(id, SUBSCRIPTION_UPDATE_JITTER_MS);
         }
         else if (result == Qv2rayBase::MessageOpt::Ignore)
         {
@@ -233,7 +236,7 @@ void MainWindow::Action_UpdateSubscription()
                 return;
             const auto gid = widget->Profile().groupId;
             if (QvProfileManager->GetGroupObject(gid).subscription_config.isSubscription)
-                QvProfileManager->UpdateSubscription(gid, true);
+                subscriptionScheduler->Schedule(gid);
             else
                 QvBaselib->Info(tr("Update Subscription"), tr("Selected group is not a subscription"));
         }
@@ -0,0 +1,125 @@
+#include "components/QueryParser/QueryParser.hpp"
+
+#include <QtTest>
+
+using namespace Qv2ray::components::QueryParser;
+
+// Some of the variables of the connection filter.
+enum TestVariable
+{
+    Variable_Name,
+    Variable_Tags,
+    Variable_Latency,
+    Variable_Connected,
+    Variable_Protocol,
+    Variable_Port,
+};
+
+const static QList<Compiler::Variable> TestVariables{
+    { u"name"_qs, Compiler::VariableType::String },       //
+    { u"tags"_qs, Compiler::VariableType::StringList },   //
+    { u"latency"_qs, Compiler::VariableType::Number },    //
+    { u"connected"_qs, Compiler::VariableType::Boolean }, //
+    { u"protocol"_qs, Compiler::VariableType::String },   //
+    { u"port"_qs, Compiler::VariableType::Number },
+};
+
+class QueryParserTest : public QObject
+{
+    Q_OBJECT
+
+  private:
+    static Compiler::CompiledProgram Compile(const QString &source)
+    {
+        return Compiler::CompiledProgram(ParseProgram(source), TestVariables, Qt::CaseInsensitive);
+    }
+
+    static void FillRow(Compiler::VariableTable &table, const QString &name)
+    {
+        table.Clear();
+        table.SetString(Variable_Name, name);
+        table.SetNumber(Variable_Latency, 120);
+        table.SetBoolean(Variable_Connected, true);
+        table.SetString(Variable_Protocol, u"vmess"_qs);
+        table.SetNumber(Variable_Port, 443);
+    }
+
+  private slots:
+    void evaluate_data()
+    {
+        QTest::addColumn<QString>("program");
+        QTest::addColumn<bool>("matches");
+
+        QTest::newRow("string, case insensitive") << u"name = \"hk node 01\""_qs << true;
+        QTest::newRow("string, other") << u"name = \"us node\""_qs << false;
+        QTest::newRow("scalar, any of a list") << u"protocol = vless | vmess"_qs << true;
+        QTest::newRow("list, all of") << u"tags = fast & hk"_qs << true;
+        QTest::newRow("list, all of, one missing") << u"tags = fast & us"_qs << false;
+        QTest::newRow("list, comma is all of") << u"tags = fast, us"_qs << false;
+        QTest::newRow("list, any of") << u"tags = us | hk"_qs << true;
+        QTest::newRow("list, not in") << u"tags != us"_qs << true;
+        QTest::newRow("statements are joined by and") << u"latency < 200; port = 443"_qs << true;
+        QTest::newRow("statements, one fails") << u"latency < 200; port = 80"_qs << false;
+        QTest::newRow("order, bound included") << u"latency >= 120"_qs << true;
+        QTest::newRow("order, above") << u"latency > 200"_qs << false;
+        QTest::newRow("order, negative bound") << u"latency > -1"_qs << false;
+        QTest::newRow("order, bound is not a number") << u"latency < abc"_qs << false;
+        QTest::newRow("boolean") << u"connected"_qs << true;
+        QTest::newRow("boolean, negated") << u"!connected"_qs << false;
+        QTest::newRow("number, not a number") << u"port = abc"_qs << false;
+        QTest::newRow("number, not equal to not a number") << u"port != abc"_qs << true;
+        QTest::newRow("all of, one not a number") << u"port = 443 & abc"_qs << false;
+        QTest::newRow("any of, one not a number") << u"port = 443 | abc"_qs << true;
+    }
+
+    // The tags are set once as a list and once as a set, both are list variables.
+    void evaluate()
+    {
+        QFETCH(QString, program);
+        QFETCH(bool, matches);
+
+        const auto compiled = Compile(program);
+        const auto name = u"HK Node 01"_qs;
+        Compiler::VariableTable table(TestVariables.size());
+
+        const QStringList tagsList{ u"fast"_qs, u"HK"_qs };
+        FillRow(table, name);
+        table.SetStringList(Variable_Tags, tagsList);
+        QCOMPARE(compiled.Evaluate(table), matches);
+
+        const QSet<QString> tagsSet{ u"fast"_qs, u"HK"_qs };
+        FillRow(table, name);
+        table.SetStringList(Variable_Tags, tagsSet);
+        QCOMPARE(compiled.Evaluate(table), matches);
+    }
+
+    void unknownIdentifier()
+    {
+        try
+        {
+            Compile(u"country = hk"_qs);
+            QFAIL("An unknown identifier must not compile.");
+        }
+        catch (const semantic_error &)
+        {
+        }
+    }
+
+    void unsetVariable()
+    {
+        const auto compiled = Compile(u"protocol = vmess"_qs);
+        Compiler::VariableTable table(TestVariables.size());
+        table.SetNumber(Variable_Port, 443);
+        try
+        {
+            compiled.Evaluate(table);
+            QFAIL("A variable which is not set must not be evaluated.");
+        }
+        catch (const evaluation_error &)
+        {
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(QueryParserTest)
+#include "QueryParserTest.moc"
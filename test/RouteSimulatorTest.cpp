@@ -0,0 +1,196 @@
+#include "components/RouteSimulator/RouteSimulator.hpp"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+class RouteSimulatorTest : public QObject
+{
+    Q_OBJECT
+
+  private:
+    static RuleObject Rule(const QString &outboundTag)
+    {
+        RuleObject rule;
+        rule.outboundTag = outboundTag;
+        return rule;
+    }
+
+    // A proxy outbound first, so that it is the default, followed by direct, block and a balancer.
+    static ProfileContent Profile(const QList<RuleObject> &rules, const QString &domainStrategy = {})
+    {
+        ProfileContent profile;
+        for (const auto &name : { u"proxy"_qs, u"direct"_qs, u"block"_qs })
+        {
+            OutboundObject out{ IOConnectionSettings{ u"freedom"_qs, u"0.0.0.0"_qs, 0 } };
+            out.name = name;
+            profile.outbounds << out;
+        }
+
+        OutboundObject balancer;
+        balancer.name = u"balancer"_qs;
+        balancer.objectType = OutboundObject::BALANCER;
+        profile.outbounds << balancer;
+
+        profile.routing.rules = rules;
+        if (!domainStrategy.isEmpty())
+            profile.routing.extraOptions[u"domainStrategy"_qs] = domainStrategy;
+        return profile;
+    }
+
+    static RouteQuery Query(const QString &target, int port = 443, const QString &network = u"tcp"_qs)
+    {
+        RouteQuery query;
+        query.target = target;
+        query.port = port;
+        query.network = network;
+        return query;
+    }
+
+  private slots:
+    void domains_data()
+    {
+        QTest::addColumn<QString>("target");
+        QTest::addColumn<QString>("outbound");
+        QTest::addColumn<qsizetype>("ruleIndex");
+
+        QTest::newRow("full") << u"www.example.com"_qs << u"direct"_qs << qsizetype(0);
+        QTest::newRow("full, other host") << u"api.example.com"_qs << u"proxy"_qs << qsizetype(-1);
+        QTest::newRow("subdomain, itself") << u"example.org"_qs << u"block"_qs << qsizetype(1);
+        QTest::newRow("subdomain, child") << u"ads.tracker.example.org"_qs << u"block"_qs << qsizetype(1);
+        QTest::newRow("subdomain, not a label") << u"badexample.org"_qs << u"proxy"_qs << qsizetype(-1);
+        QTest::newRow("keyword") << u"cdn.google-analytics.com"_qs << u"block"_qs << qsizetype(2);
+        QTest::newRow("plain is a keyword") << u"mytorrentsite.net"_qs << u"direct"_qs << qsizetype(3);
+        QTest::newRow("regexp") << u"node42.internal"_qs << u"direct"_qs << qsizetype(4);
+        QTest::newRow("case insensitive") << u"WWW.EXAMPLE.COM"_qs << u"direct"_qs << qsizetype(0);
+    }
+
+    void domains()
+    {
+        QFETCH(QString, target);
+        QFETCH(QString, outbound);
+        QFETCH(qsizetype, ruleIndex);
+
+        auto full = Rule(u"direct"_qs);
+        full.targetDomains << u"full:www.example.com"_qs;
+        auto subdomain = Rule(u"block"_qs);
+        subdomain.targetDomains << u"domain:example.org"_qs;
+        auto keyword = Rule(u"block"_qs);
+        keyword.targetDomains << u"keyword:analytics"_qs;
+        auto plain = Rule(u"direct"_qs);
+        plain.targetDomains << u"torrent"_qs;
+        auto regexp = Rule(u"direct"_qs);
+        regexp.targetDomains << u"regexp:^node[0-9]+\\.internal$"_qs;
+
+        const RouteSimulator simulator(Profile({ full, subdomain, keyword, plain, regexp }), {});
+        QVERIFY(simulator.Errors().isEmpty());
+
+        const auto decision = simulator.Route(Query(target));
+        QCOMPARE(decision.outboundTag, outbound);
+        QCOMPARE(decision.ruleIndex, ruleIndex);
+        QVERIFY(!decision.isBalancer);
+    }
+
+    void addresses()
+    {
+        auto lan = Rule(u"direct"_qs);
+        lan.targetIPs << u"10.0.0.0/8"_qs << u"192.168.1.1"_qs << u"fd00::/8"_qs;
+        auto dns = Rule(u"block"_qs);
+        dns.targetIPs << u"0.0.0.0/0"_qs;
+        dns.targetPort.from = 53;
+        dns.targetPort.to = 53;
+        dns.networks << u"udp"_qs;
+
+        const RouteSimulator simulator(Profile({ lan, dns }), {});
+        QVERIFY(simulator.Errors().isEmpty());
+
+        QCOMPARE(simulator.Route(Query(u"10.1.2.3"_qs)).outboundTag, u"direct"_qs);
+        QCOMPARE(simulator.Route(Query(u"192.168.1.1"_qs)).outboundTag, u"direct"_qs);
+        QCOMPARE(simulator.Route(Query(u"192.168.1.2"_qs)).outboundTag, u"proxy"_qs);
+        QCOMPARE(simulator.Route(Query(u"fd12::1"_qs)).outboundTag, u"direct"_qs);
+        QCOMPARE(simulator.Route(Query(u"2001:db8::1"_qs)).outboundTag, u"proxy"_qs);
+
+        // Every condition of a rule must match.
+        QCOMPARE(simulator.Route(Query(u"8.8.8.8"_qs, 53, u"udp"_qs)).outboundTag, u"block"_qs);
+        QCOMPARE(simulator.Route(Query(u"8.8.8.8"_qs, 53, u"tcp"_qs)).outboundTag, u"proxy"_qs);
+        QCOMPARE(simulator.Route(Query(u"8.8.8.8"_qs, 443, u"udp"_qs)).outboundTag, u"proxy"_qs);
+    }
+
+    void sources()
+    {
+        auto rule = Rule(u"direct"_qs);
+        rule.sourceAddresses << u"192.168.0.0/16"_qs;
+        rule.inboundTags << u"socks-in"_qs;
+        const RouteSimulator simulator(Profile({ rule }), {});
+
+        auto query = Query(u"example.com"_qs);
+        query.source = u"192.168.3.4"_qs;
+        query.inboundTag = u"socks-in"_qs;
+        QCOMPARE(simulator.Route(query).outboundTag, u"direct"_qs);
+
+        query.inboundTag = u"http-in"_qs;
+        QCOMPARE(simulator.Route(query).outboundTag, u"proxy"_qs);
+
+        query.inboundTag = u"socks-in"_qs;
+        query.source = u"10.0.0.1"_qs;
+        QCOMPARE(simulator.Route(query).outboundTag, u"proxy"_qs);
+    }
+
+    void domainStrategies()
+    {
+        auto rule = Rule(u"direct"_qs);
+        rule.targetIPs << u"203.0.113.0/24"_qs;
+
+        auto query = Query(u"example.com"_qs);
+        query.resolvedIP = u"203.0.113.7"_qs;
+
+        // Domains are never resolved by AsIs.
+        QCOMPARE(RouteSimulator(Profile({ rule }), {}).Route(query).outboundTag, u"proxy"_qs);
+        QCOMPARE(RouteSimulator(Profile({ rule }, u"IPIfNonMatch"_qs), {}).Route(query).outboundTag, u"direct"_qs);
+        QCOMPARE(RouteSimulator(Profile({ rule }, u"IPOnDemand"_qs), {}).Route(query).outboundTag, u"direct"_qs);
+
+        // IPIfNonMatch only resolves after no rule has matched the domain.
+        auto domainRule = Rule(u"block"_qs);
+        domainRule.targetDomains << u"domain:example.com"_qs;
+        QCOMPARE(RouteSimulator(Profile({ rule, domainRule }, u"IPIfNonMatch"_qs), {}).Route(query).outboundTag, u"block"_qs);
+        QCOMPARE(RouteSimulator(Profile({ rule, domainRule }, u"IPOnDemand"_qs), {}).Route(query).outboundTag, u"direct"_qs);
+    }
+
+    void balancer()
+    {
+        auto rule = Rule(u"balancer"_qs);
+        rule.protocols << u"bittorrent"_qs;
+        const RouteSimulator simulator(Profile({ rule }), {});
+
+        auto query = Query(u"example.com"_qs);
+        query.protocol = u"bittorrent"_qs;
+        const auto decision = simulator.Route(query);
+        QCOMPARE(decision.outboundTag, u"balancer"_qs);
+        QVERIFY(decision.isBalancer);
+    }
+
+    void batches()
+    {
+        auto rule = Rule(u"direct"_qs);
+        rule.targetDomains << u"domain:lan"_qs;
+        const RouteSimulator simulator(Profile({ rule }), {});
+
+        const auto decisions = simulator.Route({ Query(u"nas.lan"_qs), Query(u"example.com"_qs), Query(u"printer.lan"_qs) });
+        QCOMPARE(decisions.size(), qsizetype(3));
+        QCOMPARE(decisions[0].outboundTag, u"direct"_qs);
+        QCOMPARE(decisions[1].outboundTag, u"proxy"_qs);
+        QCOMPARE(decisions[2].outboundTag, u"direct"_qs);
+    }
+
+    void errors()
+    {
+        QTemporaryDir assets;
+        auto rule = Rule(u"direct"_qs);
+        rule.targetIPs << u"300.0.0.1"_qs << u"geoip:cn"_qs;
+        rule.targetDomains << u"regexp:("_qs;
+        const RouteSimulator simulator(Profile({ rule }), assets.path());
+        QCOMPARE(simulator.Errors().size(), qsizetype(3));
+    }
+};
+
+QTEST_GUILESS_MAIN(RouteSimulatorTest)
+#include "RouteSimulatorTest.moc"
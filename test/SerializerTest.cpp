@@ -0,0 +1,126 @@
+#include "Base64.hpp"
+#include "bench/ConnectionGenerator.hpp"
+#include "core/OutboundHandler.hpp"
+#include "core/ShareLink.hpp"
+
+#include <QtTest>
+
+constexpr auto TEST_SEED = 1;
+constexpr auto TEST_CONNECTIONS_PER_PROTOCOL = 200;
+constexpr auto TEST_MUTATIONS_PER_LINK = 16;
+constexpr auto TEST_HOSTS = 5000;
+
+class SerializerTest : public QObject
+{
+    Q_OBJECT
+
+  private:
+    const BuiltinSerializer serializer;
+
+    QList<std::pair<QString, IOConnectionSettings>> AllConnections() const
+    {
+        ConnectionGenerator generator(TEST_SEED);
+        QList<std::pair<QString, IOConnectionSettings>> connections;
+        for (const auto &protocol : serializer.SupportedProtocols())
+            connections << generator.Connections(protocol, TEST_CONNECTIONS_PER_PROTOCOL);
+        return connections;
+    }
+
+  private slots:
+    void roundTrip_data()
+    {
+        QTest::addColumn<QString>("protocol");
+        for (const auto &protocol : serializer.SupportedProtocols())
+            QTest::newRow(protocol.toUtf8().constData()) << protocol;
+    }
+
+    // The decoders fill in defaults, so the links are compared rather than the settings.
+    void roundTrip()
+    {
+        QFETCH(QString, protocol);
+
+        ConnectionGenerator generator(TEST_SEED);
+        for (const auto &[name, connection] : generator.Connections(protocol, TEST_CONNECTIONS_PER_PROTOCOL))
+        {
+            const auto link = serializer.Serialize(name, connection);
+            QVERIFY2(link, qPrintable(u"No link for \"%1\"."_qs.arg(name)));
+
+            const auto decoded = serializer.Deserialize(*link);
+            QVERIFY2(decoded, qPrintable(*link));
+            QCOMPARE(decoded->first, name);
+            QCOMPARE(decoded->second.port.from, connection.port.from);
+            QCOMPARE(serializer.Serialize(decoded->first, decoded->second).value_or(QString{}), *link);
+        }
+    }
+
+    void legacyVMess()
+    {
+        ConnectionGenerator generator(TEST_SEED);
+        for (const auto &[name, connection] : generator.Connections(u"vmess"_qs, TEST_CONNECTIONS_PER_PROTOCOL))
+        {
+            const auto link = generator.LegacyVMessLink(name, connection);
+            const auto decoded = serializer.Deserialize(link);
+            QVERIFY2(decoded, qPrintable(link));
+            QCOMPARE(decoded->first, name);
+            QCOMPARE(decoded->second.port.from, connection.port.from);
+        }
+    }
+
+    // Decodes variations of every link, what is accepted is encoded again, neither may crash.
+    void malformedLinks()
+    {
+        ConnectionGenerator generator(TEST_SEED);
+        for (const auto &[name, connection] : AllConnections())
+        {
+            const auto utf8 = serializer.Serialize(name, connection).value_or(QString{}).toUtf8();
+            for (auto i = 0; i < TEST_MUTATIONS_PER_LINK; i++)
+            {
+                if (const auto result = serializer.Deserialize(QString::fromUtf8(generator.Mutate(utf8))); result)
+                    serializer.Serialize(result->first, result->second);
+            }
+        }
+    }
+
+    // The decoders used to read the host through QUrl, ShareLink must normalise it the same way.
+    void hosts()
+    {
+        ConnectionGenerator generator(TEST_SEED);
+        for (auto i = 0; i < TEST_HOSTS; i++)
+        {
+            const auto host = generator.HostSpelling();
+            const auto link = u"vless://user@%1:443/"_qs.arg(host.contains(u':') ? u'[' + host + u']' : host);
+            const auto utf8 = link.toUtf8();
+            const auto parsed = ShareLink::Parse(utf8);
+            const QUrl url(link);
+            if (!parsed || !url.isValid())
+                continue;
+
+            QCOMPARE(parsed->Host(), url.host());
+        }
+    }
+
+    void batch()
+    {
+        const auto connections = AllConnections();
+        const auto serialized = serializer.SerializeBatch(connections);
+        QVERIFY2(serialized.skipped.isEmpty(), qPrintable(u"Skipped: "_qs + serialized.skipped.join(u", "_qs)));
+        QCOMPARE(Qv2ray::Base64::Decode(serialized.subscription), serialized.links);
+
+        const auto links = QString::fromUtf8(serialized.links).split(u'\n', Qt::SkipEmptyParts);
+        QCOMPARE(links.size(), connections.size());
+        for (auto i = 0; i < connections.size(); i++)
+            QCOMPARE(links[i], serializer.Serialize(connections[i].first, connections[i].second).value_or(QString{}));
+
+        const auto decoded = serializer.DeserializeBatch(links);
+        QCOMPARE(decoded.size(), connections.size());
+        for (auto i = 0; i < connections.size(); i++)
+        {
+            QVERIFY2(!decoded[i].error, qPrintable(links[i] + u": "_qs + decoded[i].error.value_or(QString{})));
+            QCOMPARE(decoded[i].name, connections[i].first);
+            QCOMPARE(decoded[i].outbound.port.from, connections[i].second.port.from);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(SerializerTest)
+#include "SerializerTest.moc"